@@ -0,0 +1,192 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <e3d/ogl/bvh.hh>
+
+
+
+using namespace ogl;
+
+using benchmark_clock = std::chrono::steady_clock;
+
+
+
+// Objects spread through a cube that grows with their count, so density (and
+// the number of hits per query) stays about the same at every size
+struct Scene
+{
+	std::mt19937                          random;
+	std::uniform_real_distribution<float> position;
+	std::uniform_real_distribution<float> extent;
+	std::normal_distribution<float>       direction;
+
+	explicit
+	Scene(
+		std::size_t const count
+		) :
+		random(1U),
+		position(-std::cbrt(float(count)) * 2.0F, std::cbrt(float(count)) * 2.0F),
+		extent(0.1F, 1.0F)
+	{}
+
+	auto
+	box(
+		)
+		-> Aabb
+	{
+		auto const centre = glm::vec3(position(random), position(random), position(random));
+		auto const half   = glm::vec3(extent(random), extent(random), extent(random));
+		return Aabb{ centre - half, centre + half };
+	}
+
+	auto
+	heading(
+		)
+		-> glm::vec3
+	{
+		return glm::normalize(glm::vec3(direction(random), direction(random), direction(random)));
+	}
+
+	// A camera somewhere in the scene looking a random way, seeing about as
+	// far as a box query reaches in a few hundred objects
+	auto
+	frustum(
+		)
+		-> Frustum
+	{
+		auto const eye   = glm::vec3(position(random), position(random), position(random));
+		auto const front = heading();
+		auto const up    = std::abs(front.z) < 0.99F ? glm::vec3(0.0F, 0.0F, 1.0F) : glm::vec3(1.0F, 0.0F, 0.0F);
+		return ogl::frustum(
+			glm::perspective(glm::radians(60.0F), 16.0F / 9.0F, 0.1F, 20.0F) *
+			glm::lookAt(eye, eye + front, up));
+	}
+};
+
+auto static
+milliseconds(
+	benchmark_clock::time_point const start
+	)
+	-> double
+{
+	return std::chrono::duration<double, std::milli>(benchmark_clock::now() - start).count();
+}
+
+
+
+auto
+main(
+	int    argc,
+	char** argv
+	)
+	-> int
+{
+	// Largest size to run, the default goes up to a million objects
+	auto const largest = argc > 1
+		? std::size_t(std::strtoull(argv[1], nullptr, 10))
+		: std::size_t(1000000U);
+
+	auto constexpr queries = std::size_t(10000U);
+
+	std::cout << std::fixed << std::setprecision(2) <<
+		"objects\t| insert ms\t| build ms\t| refit ms\t| box query/s\t| frustum query/s\t| raycast/s\t| height" << std::endl;
+
+	for (auto count = std::size_t(10000U); count <= largest; count *= 10U)
+	{
+		auto scene   = Scene(count);
+		auto bvh     = Bvh();
+		auto boxes   = std::vector<Aabb>(count);
+		auto proxies = std::vector<Bvh::Proxy>(count);
+
+		// Incremental insertion
+		auto start = benchmark_clock::now();
+		for (auto i = std::size_t(0U); i < count; ++i)
+		{
+			boxes[i]   = scene.box();
+			proxies[i] = bvh.insert(boxes[i], std::uint32_t(i));
+		}
+		auto const insert = milliseconds(start);
+
+		// Full rebuild
+		start = benchmark_clock::now();
+		bvh.build();
+		auto const build = milliseconds(start);
+
+		// Every object moves a little, then one refit
+		auto jitter = std::uniform_real_distribution<float>(-0.25F, 0.25F);
+		for (auto i = std::size_t(0U); i < count; ++i)
+		{
+			auto const offset = glm::vec3(jitter(scene.random), jitter(scene.random), jitter(scene.random));
+			boxes[i].minimum += offset;
+			boxes[i].maximum += offset;
+			bvh.move(proxies[i], boxes[i]);
+		}
+
+		start = benchmark_clock::now();
+		bvh.refit();
+		auto const refit = milliseconds(start);
+
+		// Box queries a few objects wide
+		auto results = std::vector<std::uint32_t>();
+		auto found   = std::size_t(0U);
+		start = benchmark_clock::now();
+		for (auto i = std::size_t(0U); i < queries; ++i)
+		{
+			auto query = scene.box();
+			query.minimum -= glm::vec3(2.0F);
+			query.maximum += glm::vec3(2.0F);
+
+			results.clear();
+			bvh.query(query, results);
+			found += results.size();
+		}
+		auto const box_rate = double(queries) / (milliseconds(start) / 1000.0);
+
+		// Cameras at random points looking random ways
+		auto frustums = std::vector<Frustum>(queries);
+		for (auto& frustum : frustums)
+			frustum = scene.frustum();
+
+		start = benchmark_clock::now();
+		for (auto const& frustum : frustums)
+		{
+			results.clear();
+			bvh.query(frustum, results);
+			found += results.size();
+		}
+		auto const frustum_rate = double(queries) / (milliseconds(start) / 1000.0);
+
+		// Rays from random points in random directions
+		auto hits = std::size_t(0U);
+		start = benchmark_clock::now();
+		for (auto i = std::size_t(0U); i < queries; ++i)
+		{
+			auto const ray = Ray{ scene.box().centre(), scene.heading() };
+
+			if (bvh.raycast(ray))
+				++hits;
+		}
+		auto const ray_rate = double(queries) / (milliseconds(start) / 1000.0);
+
+		std::cout <<
+			count << "\t| " <<
+			insert << "\t| " <<
+			build << "\t| " <<
+			refit << "\t| " <<
+			box_rate << "\t| " <<
+			frustum_rate << "\t\t| " <<
+			ray_rate << "\t| " <<
+			bvh.height() << std::endl;
+
+		// Keep the queries from being optimised away
+		if (found == 0U && hits == 0U)
+			std::cout << "No query found anything" << std::endl;
+	}
+}
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <e3d/ogl/capture.hh>
+#include <e3d/ogl/renderer.hh>
+
+
+
+using namespace ogl;
+
+using benchmark_clock = std::chrono::steady_clock;
+
+// Frames are paced like a 60Hz display, so latency counts real frames
+auto static constexpr frame_length = std::chrono::microseconds(16667);
+
+auto static
+milliseconds(
+	benchmark_clock::duration const duration
+	)
+	-> double
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+
+
+auto
+main(
+	int    argc,
+	char** argv
+	)
+	-> int
+{
+	// Frames to capture, the default is ten seconds
+	auto const frames = argc > 1
+		? std::size_t(std::strtoull(argv[1], nullptr, 10))
+		: std::size_t(600U);
+
+	renderer::headless = true;
+	renderer::width    = 1920U;
+	renderer::height   = 1080U;
+	renderer::start();
+
+	// When each frame was read back, and how long after that it was encoded
+	auto read    = std::vector<benchmark_clock::time_point>(frames + 1U);
+	auto latency = std::vector<double>();
+	auto current = std::atomic<std::uint64_t>(0U);
+	auto behind  = std::uint64_t(0U);
+	{
+		auto capture = Capture([&](Image&& image, std::uint64_t const frame)
+		{
+			latency.push_back(milliseconds(benchmark_clock::now() - read[frame]));
+			behind = std::max(behind, current.load() - frame);
+
+			if (image.pixels.empty())
+				std::cout << "Frame " << frame << " is empty" << std::endl;
+		});
+
+		auto next = benchmark_clock::now();
+		for (auto frame = std::size_t(1U); frame <= frames; ++frame)
+		{
+			// Something different every frame
+			auto const shade = float(frame % 60U) / 60.0F;
+			renderer::clear_colour(glm::vec4(shade, 1.0F - shade, 0.5F, 1.0F));
+			renderer::target();
+			renderer::clear();
+
+			current = frame;
+			read[frame] = benchmark_clock::now();
+			capture.read();
+			capture.poll();
+			renderer::display();
+
+			next += frame_length;
+			std::this_thread::sleep_until(next);
+		}
+
+		capture.flush();
+
+		std::sort(latency.begin(), latency.end());
+		auto const median = latency.empty() ? 0.0 : latency[latency.size() / 2U];
+		auto const worst  = latency.empty() ? 0.0 : latency.back();
+		auto const frame  = milliseconds(frame_length);
+
+		std::cout << std::fixed << std::setprecision(3) <<
+			frames << " frames at " << renderer::width << "x" << renderer::height << std::endl <<
+			"- render thread\t| " << capture.render_time() / double(frames) << " ms per frame" << std::endl <<
+			"- captured\t| " << capture.captured() << std::endl <<
+			"- dropped\t| " << capture.dropped() << std::endl <<
+			"- latency p50\t| " << median << " ms, " << median / frame << " frames" << std::endl <<
+			"- latency max\t| " << worst << " ms, " << worst / frame << " frames" << std::endl <<
+			"- frames behind\t| " << behind << " at most when encoded" << std::endl;
+	}
+
+	renderer::shutdown();
+}
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <e3d/ogl/jobs.hh>
+
+
+
+using namespace ogl;
+
+using benchmark_clock = std::chrono::steady_clock;
+
+
+
+// A few hundred nanoseconds of arithmetic per index and nothing shared, so
+// any loss of scaling is the scheduler's
+auto static
+kernel(
+	std::size_t const index
+	)
+	-> float
+{
+	auto value = float(index % 1024U) * 0.001F;
+	for (auto i = 0; i < 16; ++i)
+		value = std::sin(value) * 0.5F + std::cos(value * 0.25F);
+	return value;
+}
+
+auto static
+milliseconds(
+	benchmark_clock::time_point const start
+	)
+	-> double
+{
+	return std::chrono::duration<double, std::milli>(benchmark_clock::now() - start).count();
+}
+
+
+
+auto
+main(
+	int    argc,
+	char** argv
+	)
+	-> int
+{
+	// Most threads to run, the default is one per core
+	auto const largest = argc > 1
+		? std::size_t(std::strtoull(argv[1], nullptr, 10))
+		: std::size_t(std::max(std::thread::hardware_concurrency(), 1U));
+
+	auto constexpr count  = std::size_t(1U) << 18U;
+	auto constexpr rounds = 10;
+
+	auto output = std::vector<float>(count);
+	auto single = 0.0;
+
+	std::cout << std::fixed << std::setprecision(2) <<
+		count << " indices, " << rounds << " rounds" << std::endl <<
+		"threads\t| ms\t\t| speedup\t| efficiency\t| stolen" << std::endl;
+
+	for (auto threads = std::size_t(1U); threads <= largest; ++threads)
+	{
+		// One thread runs everything inline, without the scheduler
+		if (threads > 1U)
+			jobs::start(threads - 1U);
+
+		// Warm the workers and the output once before timing
+		auto const body = [&output](std::size_t const begin, std::size_t const end)
+		{
+			for (auto i = begin; i < end; ++i)
+				output[i] = kernel(i);
+		};
+		jobs::parallel_for(0U, count, 0U, body);
+
+		auto const stolen = jobs::stats().stolen;
+		auto const start  = benchmark_clock::now();
+		for (auto round = 0; round < rounds; ++round)
+			jobs::parallel_for(0U, count, 0U, body);
+		auto const elapsed = milliseconds(start) / rounds;
+
+		if (threads == 1U)
+			single = elapsed;
+
+		std::cout <<
+			threads << "\t| " <<
+			elapsed << "\t\t| " <<
+			single / elapsed << "\t\t| " <<
+			single / elapsed / double(threads) << "\t\t| " <<
+			jobs::stats().stolen - stolen << std::endl;
+
+		jobs::shutdown();
+	}
+
+	// Keep the kernel from being optimised away
+	auto sum = 0.0;
+	for (auto const value : output)
+		sum += double(value);
+	std::cout << "(checksum " << sum << ")" << std::endl;
+}
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <e3d/ogl/transform.hh>
+
+
+
+using namespace ogl;
+
+using benchmark_clock = std::chrono::steady_clock;
+
+auto static
+milliseconds(
+	benchmark_clock::time_point const start
+	)
+	-> double
+{
+	return std::chrono::duration<double, std::milli>(benchmark_clock::now() - start).count();
+}
+
+
+
+auto
+main(
+	int    argc,
+	char** argv
+	)
+	-> int
+{
+	// Largest batch to run, the default goes up to a million transforms
+	auto const largest = argc > 1
+		? std::size_t(std::strtoull(argv[1], nullptr, 10))
+		: std::size_t(1000000U);
+
+	auto random   = std::mt19937(1U);
+	auto position = std::uniform_real_distribution<float>(-100.0F, 100.0F);
+	auto axis     = std::normal_distribution<float>();
+	auto scale    = std::uniform_real_distribution<float>(0.5F, 2.0F);
+
+	std::cout << std::fixed << std::setprecision(2) <<
+		"transforms\t| glm ms\t| batch ms\t| batch, models only ms\t| speedup" << std::endl;
+
+	for (auto count = std::size_t(10000U); count <= largest; count *= 10U)
+	{
+		auto transforms = std::vector<Transform>(count);
+		auto batch      = TransformBatch();
+		for (auto& t : transforms)
+		{
+			auto q = glm::vec4(axis(random), axis(random), axis(random), axis(random));
+			q /= std::sqrt(glm::dot(q, q));
+
+			t.position    = glm::vec3(position(random), position(random), position(random));
+			t.orientation = glm::quat(q.w, q.x, q.y, q.z);
+			t.scale       = glm::vec3(scale(random), scale(random), scale(random));
+			batch.push_back(t);
+		}
+
+		auto models  = std::vector<glm::mat4>(count);
+		auto normals = std::vector<glm::mat3>(count);
+
+		// The products and general inverse the batch replaces
+		auto start = benchmark_clock::now();
+		for (auto i = std::size_t(0U); i < count; ++i)
+		{
+			auto const& t = transforms[i];
+			models[i] =
+				glm::translate(glm::mat4(1.0F), t.position) *
+				glm::mat4_cast(t.orientation) *
+				glm::scale(glm::mat4(1.0F), t.scale);
+			normals[i] = glm::inverseTranspose(glm::mat3(models[i]));
+		}
+		auto const reference = milliseconds(start);
+
+		start = benchmark_clock::now();
+		compute_matrices(batch, models.data(), normals.data());
+		auto const both = milliseconds(start);
+
+		start = benchmark_clock::now();
+		compute_matrices(batch, models.data());
+		auto const alone = milliseconds(start);
+
+		std::cout <<
+			count << "\t\t| " <<
+			reference << "\t| " <<
+			both << "\t\t| " <<
+			alone << "\t\t\t| " <<
+			reference / both << std::endl;
+
+		// Keep the matrices from being optimised away
+		if (models.back()[3][3] != 1.0F || normals.back()[0][0] == 0.0F)
+			std::cout << "Unexpected matrix" << std::endl;
+	}
+}
@@ -0,0 +1,102 @@
+#include <chrono>
+#include <iostream>
+
+#include <e3d/ogl/renderer.hh>
+#include <e3d/ogl/shader.hh>
+
+
+
+using namespace ogl;
+
+using benchmark_clock = std::chrono::steady_clock;
+
+// A few matrices, and an array whose elements are not reflected by name
+auto static constexpr vertex_source = R"(#version 410
+layout (location = 0) in vec3 in_position;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec4 lights[4];
+
+void main()
+{
+	gl_Position = projection * view * model * vec4(in_position, 1.0F) + lights[0] + lights[1];
+}
+)";
+
+auto static constexpr fragment_source = R"(#version 410
+out vec4 colour;
+
+void main()
+{
+	colour = vec4(1.0F);
+}
+)";
+
+auto static constexpr binds = 1000000;
+
+auto static
+nanoseconds(
+	benchmark_clock::time_point const start
+	)
+	-> double
+{
+	return std::chrono::duration<double, std::nano>(benchmark_clock::now() - start).count() / binds;
+}
+
+
+
+auto
+main(
+	)
+	-> int
+{
+	renderer::headless = true;
+	renderer::start();
+
+	auto shader = Shader("Uniforms");
+	shader.add(GL_VERTEX_SHADER, Shader::Source, vertex_source);
+	shader.add(GL_FRAGMENT_SHADER, Shader::Source, fragment_source);
+	shader.build();
+	shader.use();
+
+	auto const matrix = glm::mat4(1.0F);
+	auto       sum    = GLint(0);
+
+	// Location lookups alone, through the table and through the driver
+	auto start = benchmark_clock::now();
+	for (auto i = 0; i < binds; ++i)
+		sum += shader.uniform_location(i & 1 ? "model"_uniform : "view"_uniform);
+	auto const table = nanoseconds(start);
+
+	start = benchmark_clock::now();
+	for (auto i = 0; i < binds; ++i)
+		sum += glGetUniformLocation(shader.id(), i & 1 ? "model" : "view");
+	auto const driver = nanoseconds(start);
+
+	// Array elements resolve through the driver once, then the table
+	start = benchmark_clock::now();
+	for (auto i = 0; i < binds; ++i)
+		sum += shader.uniform_location(i & 1 ? "lights[1]"_uniform : "lights[2]"_uniform);
+	auto const elements = nanoseconds(start);
+
+	// Whole binds, lookup and upload
+	start = benchmark_clock::now();
+	for (auto i = 0; i < binds; ++i)
+		shader.bind(i & 1 ? "model"_uniform : "view"_uniform, matrix);
+	glFinish();
+	auto const bound = nanoseconds(start);
+
+	std::cout <<
+		binds << " lookups, ns each" << std::endl <<
+		"- table\t\t| " << table << std::endl <<
+		"- driver\t| " << driver << std::endl <<
+		"- array element\t| " << elements << std::endl <<
+		binds << " binds, ns each" << std::endl <<
+		"- table\t\t| " << bound << std::endl <<
+		"(checksum " << sum << ")" << std::endl;
+
+	shader.clean();
+	renderer::shutdown();
+}
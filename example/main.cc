@@ -1,6 +1,12 @@
 #include <iostream>
+#include <string_view>
 
 #include <e3d/ogl/app.hh>
+#include <e3d/ogl/batch.hh>
+#include <e3d/ogl/occlusion.hh>
+#include <e3d/ogl/profiler.hh>
+#include <e3d/ogl/shader_library.hh>
+#include <e3d/ogl/watcher.hh>
 
 
 
@@ -8,14 +14,27 @@ using namespace ogl;
 
 
 
-// Shader
+// Shaders
+auto static shaders = ShaderLibrary();
 std::shared_ptr<Shader> static lambert;
 
+// Edited shader files are reloaded while running
+auto static watcher = ShaderWatcher();
+
 // Meshes
 auto static ground = Mesh();
 auto static cube   = Mesh();
 auto static sphere = Mesh();
 
+// Static scenery drawn with one call per shader
+auto static scenery = StaticBatch();
+
+// Scenery hidden behind the large meshes is not drawn
+auto static occlusion = OcclusionBuffer();
+
+// Turned by fixed updates, drawn between ticks
+auto static spinner = Mesh();
+
 
 
 void setup()
@@ -25,15 +44,18 @@ void setup()
 
 	// App settings
 	renderer::clear_colour(glm::vec4(0.2F, 0.3F, 0.3F, 1.0F));
+	renderer::reverse_z(true);
 	renderer::camera.position = glm::vec3(0.0F, 20.0F, 5.0F);
 	renderer::camera.look_at(glm::vec3(0.0F));
 	renderer::camera.sensitivity = 0.001F;
 
-	// Shader
-	lambert = std::make_shared<Shader>("Lambert");
+	// Shaders
+	lambert = shaders.create("Lambert");
 	lambert->add(GL_VERTEX_SHADER, Shader::File, "resources/shaders/lambert.vert");
 	lambert->add(GL_FRAGMENT_SHADER, Shader::File, "resources/shaders/lambert.frag");
-	lambert->build();
+	shaders.build();
+	shaders.report();
+	watcher.watch(lambert);
 
 	// Meshes
 	ground.load(Mesh::Quad);
@@ -47,48 +69,113 @@ void setup()
 	sphere.load(Mesh::File, "resources/models/sphere.obj");
 	sphere.position += glm::vec3(-1.0F, 0.0F, 1.0F);
 	sphere.shader = lambert;
+
+	// None of the meshes move, so merge them
+	scenery.add(ground);
+	scenery.add(cube);
+	scenery.add(sphere);
+	scenery.build();
+
+	spinner.load(Mesh::Cube);
+	spinner.position = glm::vec3(0.0F, 0.0F, 2.0F);
+	spinner.scale = glm::vec3(0.5F);
+	spinner.shader = lambert;
+	app::track(spinner);
+}
+
+void fixed_update(float delta_time)
+{
+	spinner.rotate(delta_time * 90.0F, glm::vec3(0.0F, 0.0F, 1.0F));
 }
 
 void render()
 {
+	// Swap in any edited shaders that have finished compiling
+	watcher.poll();
+
+	// Time the scene on the GPU
+	profiler::begin_gpu("scene");
+
 	// Clear the screen
 	renderer::clear();
 
-	// Use the shader
-	lambert->use();
+	// Large meshes hide what is behind them
+	occlusion.begin(renderer::camera.view_projection());
+	occlusion.add(ground);
+	occlusion.add(cube);
+	occlusion.build();
 
-	// Function to bind common uniforms for a mesh
-	auto const static bind = [](Mesh const& m, Shader const& s)
+	// Batched meshes are already in world space
+	auto const& frustum = renderer::camera.frustum();
+	scenery.draw([](Shader const& s)
 	{
-		s.bind("translate", m.translate_matrix());
-		s.bind("rotate",    m.rotate_matrix());
-		s.bind("scale",     m.scale_matrix());
-	};
-
-	// Bind camera matrices
-	lambert->bind("projection", renderer::camera.projection());
-	lambert->bind("view", renderer::camera.view());
-
-	// Bind matrices and draw mesh
-	bind(sphere, *lambert);
-	renderer::draw(sphere);
-
-	bind(cube, *lambert);
-	renderer::draw(cube);
-
-	bind(ground, *lambert);
-	renderer::draw(ground);
+		s.bind("projection", renderer::camera.projection());
+		s.bind("view",       renderer::camera.view());
+		s.bind("translate",  glm::mat4(1.0F));
+		s.bind("rotate",     glm::mat4(1.0F));
+		s.bind("scale",      glm::mat4(1.0F));
+	}, &frustum, renderer::camera.version(), &occlusion);
+
+	// Slerp from the last tick towards the current one
+	auto const t = interpolate(spinner.previous_transform(), spinner.current_transform(), app::alpha());
+	spinner.shader->use();
+	spinner.shader->bind("projection", renderer::camera.projection());
+	spinner.shader->bind("view",       renderer::camera.view());
+	spinner.shader->bind("translate",  glm::translate(glm::mat4(1.0F), t.position));
+	spinner.shader->bind("rotate",     glm::mat4_cast(t.orientation));
+	spinner.shader->bind("scale",      glm::scale(glm::mat4(1.0F), t.scale));
+	renderer::draw(spinner);
+
+	profiler::end_gpu();
+
+	// Headless runs save a frame and exit
+	if (renderer::headless)
+	{
+		auto static frame = 0;
+		if (++frame == 60)
+		{
+			write_image(renderer::capture(), "frame.png");
+			renderer::stop();
+		}
+	}
 
 	// Display the render on screen
 	renderer::display();
 }
 
+void finish()
+{
+	// Keep the last frames for inspection in a trace viewer
+	profiler::write_trace("trace.json");
+
+	auto const frame = profiler::frame_time();
+	std::cout << "Frame time p50: " << frame.p50 <<
+		"ms, p99: " << frame.p99 << "ms" << std::endl;
+
+	// Culling pays off when the draws it saves cost more than this
+	auto const culling = occlusion.stats();
+	std::cout << "Occlusion culled " <<
+		culling.culled << " of " <<
+		culling.tested << " draws for " <<
+		culling.cost() << "ms (" <<
+		culling.triangles << " occluder triangles)" << std::endl;
+}
+
 auto
 main(
+	int    argc,
+	char** argv
 	)
 	-> int
 {
+	// Render offscreen, e.g. on machines without a GPU or display
+	for (auto i = 1; i < argc; ++i)
+		if (std::string_view(argv[i]) == "--headless")
+			renderer::headless = true;
+
 	app::setup_function = setup;
+	app::fixed_update_function = fixed_update;
 	app::render_function = render;
+	app::close_function = finish;
 	app::run();
 }
@@ -1,12 +1,56 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
+#include "mesh.hh"
 #include "renderer.hh"
+#include "transform.hh"
 
 namespace ogl::app
 {
 
+// Types
+// What happens to time the fixed updates fall behind on
+enum class Overrun
+{
+	// Discard the backlog past max_substeps ticks
+	Drop,
+
+	// Drop and slow simulated time down while ticks keep hitting the cap,
+	// easing back to real time once they fit
+	Dilate,
+
+	// Drop and run fewer, longer ticks while they cost more than tick_budget
+	// of real time. Fixed updates can read the interval to cut quality too
+	Adaptive
+};
+
+// Fixed update catch-up, times in seconds
+struct StepStats
+{
+	Overrun       policy     = Overrun::Drop;
+	std::uint32_t substeps   = 0U;
+	std::uint64_t capped     = 0U;
+	double        dropped    = 0.0;
+	float         time_scale = 1.0F;
+
+	// Base ticks per tick and the smoothed cost of one, in milliseconds
+	std::uint32_t interval   = 1U;
+	double        tick_cost  = 0.0;
+};
+
+// Loop timings over the last second, in milliseconds
+struct LoopStats
+{
+	double        average = 0.0;
+	double        maximum = 0.0;
+	std::uint64_t count   = 0U;
+};
+
+
+
 // Functions
 std::function<void()>      extern setup_function;
 std::function<void()>      extern input_function;
@@ -15,10 +59,116 @@ std::function<void(float)> extern fixed_update_function;
 std::function<void()>      extern render_function;
 std::function<void()>      extern close_function;
 
+// Fill a snapshot after every tick, the transforms still hold an older state
+// to reuse their storage
+std::function<void(Snapshot&)> extern publish_function;
+
+
+
+// Timing
+// Seconds per fixed update, read every frame
+float extern tick_rate;
+
+// Frames per second the loop is paced to, zero for no limit
+float extern max_frame_rate;
+
+// Seconds every frame advances simulated time by, zero to follow the wall
+// clock. Gives reproducible runs (e.g. benchmarks), so it keeps the
+// simulation on the render thread and Adaptive at the base tick
+float extern fixed_frame;
+
+
+
+// Catch-up
+// Most ticks run per frame (or back to back on the simulation thread), the
+// policy for the rest and the share of real time ticks may cost, read every
+// frame
+std::uint32_t extern max_substeps;
+Overrun       extern overrun;
+float         extern tick_budget;
+
+
+
+// Input
+// Fixed updates read input::state(), which holds exactly the window events
+// of the time their tick stands for. Late latching polls again right before
+// rendering and turns the camera then, rather than at the start of the frame
+bool extern late_latch;
+
+
+
+// Threading
+// Job system workers besides the main thread, zero for one per core
+std::size_t extern workers;
+
+// Run fixed updates and publishing on a simulation thread, which must not
+// touch GL or the renderer
+bool extern threaded;
+
+
+
 // Run application
 auto
 run(
 	)
 	-> void;
 
+
+
+// Snapshots
+// Latest published simulation state and the one before it, render time lies
+// alpha() of a tick past the previous one
+auto
+snapshot(
+	)
+	-> Snapshot const&;
+
+auto
+previous_snapshot(
+	)
+	-> Snapshot const&;
+
+auto
+alpha(
+	)
+	-> float;
+
+// Meshes moved by fixed updates, their transform is saved before every tick
+// so drawing with model_matrix(alpha()) is smooth at any frame rate. Threaded
+// runs hand transforms over in snapshots instead
+auto
+track(
+	Mesh& mesh
+	)
+	-> void;
+
+auto
+untrack(
+	Mesh const& mesh
+	)
+	-> void;
+
+
+
+// Statistics
+auto
+step_stats(
+	)
+	-> StepStats;
+
+auto
+render_stats(
+	)
+	-> LoopStats;
+
+auto
+simulation_stats(
+	)
+	-> LoopStats;
+
+auto
+report(
+	)
+	-> void;
+
 } // namespace ogl::app
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/vec2.hpp>
+
+#include "../obj/obj.hh"
+#include "image.hh"
+#include "texture.hh"
+
+namespace ogl
+{
+
+// Bottom left skyline packer for a single page
+class Skyline
+{
+	struct Node
+	{
+		std::uint32_t x     = 0U;
+		std::uint32_t y     = 0U;
+		std::uint32_t width = 0U;
+	};
+
+	std::uint32_t     width_;
+	std::uint32_t     height_;
+	std::vector<Node> nodes_;
+	std::uint64_t     used_ = 0U;
+
+public:
+
+	// Constructors
+	Skyline(
+		std::uint32_t width,
+		std::uint32_t height
+		);
+
+
+
+	// Place a rectangle, lowest top edge first
+	auto
+	insert(
+		std::uint32_t width,
+		std::uint32_t height
+		)
+		-> std::optional<glm::uvec2>;
+
+	// Fraction of the page covered
+	auto
+	occupancy(
+		) const
+		-> float;
+};
+
+
+
+// Packs material textures into the layers of one 2D texture array. Batched
+// meshes added with their region (see StaticBatch::add) carry the layer per
+// vertex, so draws with different materials share a single bind and the
+// atlas shaders (resources/shaders/atlas.*)
+class TextureAtlas
+{
+public:
+
+	// Types
+	// Where a texture ended up, uvs map to offset + uv * scale
+	struct Region
+	{
+		std::uint32_t layer  = 0U;
+		glm::vec2     offset = glm::vec2(0.0F);
+		glm::vec2     scale  = glm::vec2(1.0F);
+
+		// Atlas uv of a texture uv, a region cannot repeat so it is clamped
+		auto
+		map(
+			glm::vec2 uv
+			) const
+			-> glm::vec2;
+	};
+
+private:
+
+	struct Entry
+	{
+		Image                  image;
+		std::optional<Region>  region;
+	};
+
+	// Details
+	GLuint  size_;
+	GLuint  padding_;
+	Texture texture_;
+
+	std::unordered_map<std::string, Entry> entries_;
+	std::vector<Skyline>                   layers_;
+
+public:
+
+	// Constructors
+	// Layers are size x size, every texture gets a padding border of its own
+	// edge pixels so mip levels do not bleed into neighbours
+	explicit
+	TextureAtlas(
+		GLuint size    = 2048U,
+		GLuint padding = 4U
+		);
+
+
+
+	// Decode a texture for packing
+	auto
+	add(
+		std::string const& path
+		)
+		-> bool;
+
+	// Add the diffuse map of a material, relative to a directory
+	auto
+	add_material(
+		obj::Material const& material,
+		std::string const&   directory
+		)
+		-> bool;
+
+	// Pack largest first and upload every layer
+	auto
+	build(
+		)
+		-> bool;
+
+
+
+	// Packed location of a texture
+	auto
+	region(
+		std::string const& path
+		) const
+		-> std::optional<Region>;
+
+	// Rewrite the uvs of a mesh into its diffuse map's region, returns the
+	// layer to sample (repeating uvs are clamped)
+	auto
+	remap(
+		obj::Mesh&         mesh,
+		std::string const& directory
+		) const
+		-> std::optional<std::uint32_t>;
+
+
+
+	// Details
+	auto
+	texture(
+		) const
+		-> Texture const&;
+
+	auto
+	layers(
+		) const
+		-> std::size_t;
+
+	auto
+	bind(
+		GLuint unit
+		) const
+		-> void;
+};
+
+} // namespace ogl
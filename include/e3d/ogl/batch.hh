@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "../obj/obj.hh"
+#include "atlas.hh"
+#include "bounds.hh"
+#include "mesh.hh"
+#include "occlusion.hh"
+#include "shader.hh"
+#include "transform.hh"
+
+namespace ogl
+{
+
+// Static meshes merged into shared buffers, drawn with one call per shader
+class StaticBatch
+{
+public:
+
+	// Types
+	// Layout matches glMultiDrawElementsIndirect
+	struct DrawElementsIndirectCommand
+	{
+		GLuint count          = 0U;
+		GLuint instance_count = 1U;
+		GLuint first_index    = 0U;
+		GLint  base_vertex    = 0;
+		GLuint base_instance  = 0U;
+	};
+
+	// Called once per shader group after it is in use
+	using bind_function = std::function<void(Shader const&)>;
+
+private:
+
+	// Meshes waiting for build, in model space until build transforms them
+	// all at once
+	struct Pending
+	{
+		std::vector<obj::Vertex> vertices;
+		std::shared_ptr<Shader>  shader;
+		Transform                transform;
+		Aabb                     bounds;
+		std::uint32_t            layer = 0U;
+	};
+
+	// Draws sharing a shader, commands are contiguous
+	struct Group
+	{
+		std::shared_ptr<Shader> shader;
+		std::size_t             first = 0U;
+		std::size_t             count = 0U;
+
+		// Range of this frame's visible commands
+		std::size_t visible_first = 0U;
+		std::size_t visible_count = 0U;
+	};
+
+
+
+	// Details
+	std::vector<Pending> pending_;
+
+	// Buffers
+	GLuint vao_ = 0U;
+	GLuint vbo_ = 0U;
+	GLuint lbo_ = 0U;
+	GLuint ebo_ = 0U;
+	GLuint ibo_ = 0U;
+
+	// Draws in group order, bounds for culling
+	std::vector<DrawElementsIndirectCommand> commands_;
+	std::vector<Aabb>                        bounds_;
+	std::vector<Group>                       groups_;
+
+	// Per frame scratch for the visible commands
+	std::vector<std::uint8_t>                inside_;
+	std::vector<DrawElementsIndirectCommand> visible_;
+	std::vector<GLsizei>                     counts_;
+	std::vector<void const*>                 offsets_;
+
+	// Camera version the visible commands were gathered for, zero for none
+	std::uint64_t                            gathered_ = 0U;
+
+	// Statistics
+	std::size_t draw_calls_    = 0U;
+	std::size_t visible_count_ = 0U;
+
+public:
+
+	// Constructors
+	StaticBatch(
+		) = default;
+
+	StaticBatch(
+		StaticBatch const&
+		)
+		= delete;
+
+	auto
+	operator=(
+		StaticBatch const&
+		)
+		-> StaticBatch&
+		= delete;
+
+	~StaticBatch(
+		);
+
+
+
+	// Build
+	// Copy a mesh with its current transform
+	auto
+	add(
+		Mesh const& mesh
+		)
+		-> void;
+
+	// Copy a mesh textured from an atlas, its uvs are moved into the region
+	// and its vertices carry the layer (unsigned attribute 3)
+	auto
+	add(
+		Mesh                 const& mesh,
+		TextureAtlas::Region const& region
+		)
+		-> void;
+
+	// Upload everything added so far, the meshes are no longer needed
+	auto
+	build(
+		)
+		-> bool;
+
+	auto
+	clear(
+		)
+		-> void;
+
+
+
+	// Draw every group, skipping meshes outside the frustum. Given the camera
+	// version the frustum came from, a static camera reuses the last culling.
+	// Meshes hidden behind the occluders are skipped too, which culls every
+	// frame as the occluders may move
+	auto
+	draw(
+		bind_function const& bind      = bind_function(),
+		Frustum const*       frustum   = nullptr,
+		std::uint64_t        version   = 0U,
+		OcclusionBuffer*     occlusion = nullptr
+		)
+		-> void;
+
+
+
+	// Statistics
+	auto
+	size(
+		) const
+		-> std::size_t;
+
+	auto
+	draw_calls(
+		) const
+		-> std::size_t;
+
+	auto
+	visible(
+		) const
+		-> std::size_t;
+
+private:
+
+	// Copy into pending, moving uvs into the region if there is one
+	auto
+	bake(
+		Mesh                 const& mesh,
+		TextureAtlas::Region const* region
+		)
+		-> void;
+
+	// Cull and collect the visible commands
+	auto
+	gather(
+		Frustum const*   frustum,
+		OcclusionBuffer* occlusion
+		)
+		-> void;
+};
+
+} // namespace ogl
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <limits>
+
+#include <glm/glm.hpp>
+
+namespace ogl
+{
+
+// Axis aligned bounding box
+struct Aabb
+{
+	glm::vec3 minimum = glm::vec3( std::numeric_limits<float>::max());
+	glm::vec3 maximum = glm::vec3(-std::numeric_limits<float>::max());
+
+	// Details
+	auto
+	centre(
+		) const
+		-> glm::vec3;
+
+	auto
+	extent(
+		) const
+		-> glm::vec3;
+
+	auto
+	surface_area(
+		) const
+		-> float;
+
+	auto
+	is_valid(
+		) const
+		-> bool;
+
+	// Tests
+	auto
+	contains(
+		Aabb const& other
+		) const
+		-> bool;
+
+	auto
+	overlaps(
+		Aabb const& other
+		) const
+		-> bool;
+
+	// Growth
+	auto
+	expand(
+		glm::vec3 point
+		)
+		-> void;
+
+	auto
+	expand(
+		Aabb const& other
+		)
+		-> void;
+};
+
+// Ray with normalised direction
+struct Ray
+{
+	glm::vec3 origin    = glm::vec3(0.0F);
+	glm::vec3 direction = glm::vec3(0.0F, 1.0F, 0.0F);
+};
+
+// Six planes (left, right, bottom, top, near, far) pointing inwards, near and
+// far swap with reversed depth. A far plane at infinity has no normal and
+// never culls
+struct Frustum
+{
+	std::array<glm::vec4, 6> planes;
+};
+
+
+
+// Combine two boxes
+auto
+merge(
+	Aabb const& a,
+	Aabb const& b
+	)
+	-> Aabb;
+
+// Box enclosing a box after a transformation
+auto
+transform(
+	Aabb      const& box,
+	glm::mat4 const& matrix
+	)
+	-> Aabb;
+
+// Extract normalised planes from a view-projection matrix, clip depth runs
+// from zero to one rather than minus one to one with glClipControl
+auto
+frustum(
+	glm::mat4 const& view_projection,
+	bool             zero_to_one = false
+	)
+	-> Frustum;
+
+
+
+// Distance along ray to box entry, negative when missed
+auto
+intersect(
+	Ray   const& ray,
+	Aabb  const& box,
+	float        max_distance = std::numeric_limits<float>::max()
+	)
+	-> float;
+
+// Box classification against frustum
+enum class Containment
+{
+	Outside,
+	Intersects,
+	Inside
+};
+
+auto
+classify(
+	Frustum const& frustum,
+	Aabb    const& box
+	)
+	-> Containment;
+
+} // namespace ogl
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "bounds.hh"
+
+namespace ogl
+{
+
+// Dynamic bounding volume hierarchy over object bounds
+class Bvh
+{
+public:
+
+	// Types
+	// Leaf handle, stable until removed (also across rebuilds)
+	using Proxy = std::uint32_t;
+
+	Proxy static constexpr null = std::numeric_limits<Proxy>::max();
+
+	// Closest ray hit
+	struct Hit
+	{
+		std::uint32_t object   = 0U;
+		float         distance = 0.0F;
+	};
+
+	// Optional narrow phase for ray casts, returns distance on hit
+	using ray_test = std::function<std::optional<float>(std::uint32_t, Ray const&)>;
+
+private:
+
+	struct Node
+	{
+		Aabb          bounds;
+		Proxy         parent = null;
+		Proxy         left   = null;
+		Proxy         right  = null;
+		std::uint32_t object = 0U;
+		bool          used   = false;
+
+		auto
+		is_leaf(
+			) const
+			-> bool
+		{
+			return left == null;
+		}
+	};
+
+
+
+	// Details
+	std::vector<Node>  nodes_;
+	std::vector<Proxy> free_;
+	Proxy              root_   = null;
+	std::size_t        leaves_ = 0U;
+
+public:
+
+	// Bins used by the surface area heuristic builder
+	std::uint32_t bins = 16U;
+
+
+
+	// Queries
+	auto
+	size(
+		) const
+		-> std::size_t;
+
+	auto
+	height(
+		) const
+		-> std::size_t;
+
+	auto
+	cost(
+		) const
+		-> float;
+
+	auto
+	object(
+		Proxy proxy
+		) const
+		-> std::uint32_t;
+
+	auto
+	bounds(
+		Proxy proxy
+		) const
+		-> Aabb const&;
+
+
+
+	// Management
+	auto
+	insert(
+		Aabb const&   bounds,
+		std::uint32_t object
+		)
+		-> Proxy;
+
+	auto
+	remove(
+		Proxy proxy
+		)
+		-> void;
+
+	// Set leaf bounds, tree is corrected by the next refit
+	auto
+	move(
+		Proxy       proxy,
+		Aabb const& bounds
+		)
+		-> void;
+
+	// Full top-down surface area heuristic build
+	auto
+	build(
+		)
+		-> void;
+
+	// Bottom-up bounds update with tree rotations
+	auto
+	refit(
+		)
+		-> void;
+
+	auto
+	clear(
+		)
+		-> void;
+
+
+
+	// Spatial queries, matching objects are appended to results
+	auto
+	query(
+		Aabb const&                 bounds,
+		std::vector<std::uint32_t>& results
+		) const
+		-> void;
+
+	auto
+	query(
+		Frustum const&              frustum,
+		std::vector<std::uint32_t>& results
+		) const
+		-> void;
+
+	auto
+	raycast(
+		Ray      const& ray,
+		float           max_distance = std::numeric_limits<float>::max(),
+		ray_test const& test         = ray_test()
+		) const
+		-> std::optional<Hit>;
+
+private:
+
+	// Nodes
+	auto
+	allocate(
+		)
+		-> Proxy;
+
+	auto
+	release(
+		Proxy proxy
+		)
+		-> void;
+
+	auto
+	insert_leaf(
+		Proxy leaf
+		)
+		-> void;
+
+	auto
+	remove_leaf(
+		Proxy leaf
+		)
+		-> void;
+
+	auto
+	rotate(
+		Proxy node
+		)
+		-> void;
+
+	auto
+	swap(
+		Proxy child,
+		Proxy grandchild
+		)
+		-> void;
+};
+
+} // namespace ogl
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstdint>
+
 #include <glm/glm.hpp>
 
+#include "bounds.hh"
+
 namespace ogl
 {
 
@@ -25,6 +29,12 @@ public:
 	float near   = 0.01F;
 	float far    = 100.0F;
 
+	// Depth precision, reversed depth puts the far plane at infinity and
+	// clears to zero (see renderer::reverse_z, which keeps these in step
+	// with the context)
+	bool reverse_z        = false;
+	bool clip_zero_to_one = false;
+
 private:
 
 	float aspect_ = 1.0F;
@@ -38,6 +48,37 @@ private:
 	glm::vec3 front_ = glm::vec3(0.0F, 1.0F, 0.0F);
 	glm::vec3 up_    = glm::vec3(0.0F, 0.0F, 1.0F);
 
+	// Everything the matrices depend on, public attributes are written
+	// directly so changes are found by comparing against these
+	struct Inputs
+	{
+		glm::vec3 position;
+		glm::vec3 front;
+		glm::vec3 up;
+		float     fov;
+		float     near;
+		float     far;
+		float     aspect;
+		bool      reverse_z;
+		bool      clip_zero_to_one;
+
+		auto
+		operator==(
+			Inputs const& other
+			) const
+			-> bool;
+	};
+
+	// Matrices and planes built from the inputs, rebuilt on first use after
+	// a change (not thread safe, like the rest of the camera)
+	mutable Inputs        inputs_{};
+	mutable bool          cached_          = false;
+	mutable std::uint64_t version_         = 0U;
+	mutable glm::mat4     view_            = glm::mat4(1.0F);
+	mutable glm::mat4     projection_      = glm::mat4(1.0F);
+	mutable glm::mat4     view_projection_ = glm::mat4(1.0F);
+	mutable Frustum       frustum_{};
+
 public:
 
 	enum Move
@@ -73,12 +114,40 @@ public:
 	auto
 	projection(
 		) const
-		-> glm::mat4;
+		-> glm::mat4 const&;
 
 	auto
 	view(
 		) const
-		-> glm::mat4;
+		-> glm::mat4 const&;
+
+	auto
+	view_projection(
+		) const
+		-> glm::mat4 const&;
+
+	// Changes whenever the matrices do and is unique across cameras, dependent
+	// caches (culling results, uniform buffers) can skip their work while it
+	// stays the same
+	auto
+	version(
+		) const
+		-> std::uint64_t;
+
+
+
+	// Culling and picking
+	auto
+	frustum(
+		) const
+		-> Frustum const&;
+
+	auto
+	ray(
+		glm::vec2 screen_position,
+		glm::vec2 resolution
+		) const
+		-> Ray;
 
 
 
@@ -127,6 +196,11 @@ private:
 	update_vectors(
 		)
 		-> void;
+
+	auto
+	refresh(
+		) const
+		-> void;
 };
 
 } // namespace ogl
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "framebuffer.hh"
+#include "image.hh"
+
+namespace ogl
+{
+
+// Asynchronous framebuffer readback through a ring of pixel buffers
+class Capture
+{
+public:
+
+	// Types
+	// Called on the encoder thread for every finished frame
+	using encoder = std::function<void(Image&&, std::uint64_t)>;
+
+private:
+
+	enum State
+	{
+		Free,
+		Pending,
+		Encoding
+	};
+
+	struct Slot
+	{
+		GLuint             buffer   = 0U;
+		GLsync             fence    = nullptr;
+		std::uint8_t*      mapped   = nullptr;
+		std::size_t        capacity = 0U;
+		std::uint32_t      width    = 0U;
+		std::uint32_t      height   = 0U;
+		std::uint64_t      frame    = 0U;
+		std::atomic<State> state    = Free;
+	};
+
+	struct Job
+	{
+		Slot*         slot  = nullptr;
+		Image         image;
+		std::uint64_t frame = 0U;
+	};
+
+
+
+	// Details
+	encoder                 encode_;
+	std::unique_ptr<Slot[]> slots_;
+	std::size_t             count_      = 0U;
+	std::size_t             next_       = 0U;
+	std::uint64_t           frame_      = 0U;
+	bool                    persistent_ = false;
+
+	// Encoder thread
+	std::thread             thread_;
+	std::mutex              mutex_;
+	std::condition_variable condition_;
+	std::deque<Job>         jobs_;
+	bool                    stopping_ = false;
+
+	// Statistics
+	std::atomic<std::uint64_t> captured_ = 0U;
+	std::uint64_t              dropped_  = 0U;
+	double                     time_     = 0.0;
+
+public:
+
+	// Constructors
+	explicit
+	Capture(
+		encoder     encode,
+		std::size_t buffers = 3U
+		);
+
+	Capture(
+		Capture const&
+		)
+		= delete;
+
+	auto
+	operator=(
+		Capture const&
+		)
+		-> Capture&
+		= delete;
+
+	~Capture(
+		);
+
+
+
+	// Queue a readback of a framebuffer (or the current output)
+	auto
+	read(
+		Framebuffer const* framebuffer = nullptr
+		)
+		-> void;
+
+	// Hand finished transfers to the encoder, call once per frame
+	auto
+	poll(
+		)
+		-> void;
+
+	// Block until every queued frame has been encoded
+	auto
+	flush(
+		)
+		-> void;
+
+
+
+	// Statistics
+	auto
+	captured(
+		) const
+		-> std::uint64_t;
+
+	auto
+	dropped(
+		) const
+		-> std::uint64_t;
+
+	// Total milliseconds spent on the render thread
+	auto
+	render_time(
+		) const
+		-> double;
+
+private:
+
+	auto
+	run(
+		)
+		-> void;
+
+	auto
+	allocate(
+		Slot&       slot,
+		std::size_t size
+		)
+		-> void;
+
+	auto
+	submit(
+		Job job
+		)
+		-> void;
+};
+
+} // namespace ogl
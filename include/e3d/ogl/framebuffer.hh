@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 #define GLEW_STATIC
 #include <GL/glew.h>
 
@@ -10,11 +12,51 @@ namespace ogl
 
 class Framebuffer
 {
-	GLuint  buffer_;
-	GLuint  width_;
-	GLuint  height_;
-	Texture frame_;
-	Texture depth_;
+public:
+
+	// Types
+	// Everything that decides whether two targets are interchangeable
+	struct Descriptor
+	{
+		GLuint width  = 0U;
+		GLuint height = 0U;
+		GLenum colour = GL_RGBA8;
+
+		// Zero for no depth attachment, floating point so reversed depth
+		// keeps its precision
+		GLenum depth = GL_DEPTH_COMPONENT32F;
+
+		// Above one renders multisampled and resolves into frame()
+		GLuint samples = 0U;
+
+		auto
+		operator==(
+			Descriptor const& other
+			) const
+			-> bool;
+
+		// Same formats, any size
+		auto
+		is_compatible(
+			Descriptor const& other
+			) const
+			-> bool;
+
+		// Samples limited to what the context allows for these formats
+		auto
+		supported(
+			) const
+			-> Descriptor;
+	};
+
+private:
+
+	Descriptor descriptor_;
+	GLuint     buffer_  = 0U;
+	GLuint     resolve_ = 0U;
+	Texture    colour_;
+	Texture    depth_;
+	Texture    resolved_;
 
 public:
 
@@ -24,15 +66,57 @@ public:
 		GLuint height
 		);
 
+	explicit
+	Framebuffer(
+		Descriptor const& descriptor
+		);
+
+	Framebuffer(
+		Framebuffer const&
+		)
+		= delete;
+
+	auto
+	operator=(
+		Framebuffer const&
+		)
+		-> Framebuffer&
+		= delete;
+
 	~Framebuffer(
 		);
 
+	// Reallocate attachment storage, keeping every GL name
+	auto
+	resize(
+		GLuint width,
+		GLuint height
+		)
+		-> void;
+
+	// Blit multisampled colour into frame(), nothing to do otherwise
+	auto
+	resolve(
+		) const
+		-> void;
+
 	// Details
+	auto
+	descriptor(
+		) const
+		-> Descriptor const&;
+
 	auto
 	buffer(
 		) const
 		-> GLuint;
 
+	// Framebuffer to read pixels from, the resolved copy when multisampled
+	auto
+	read_buffer(
+		) const
+		-> GLuint;
+
 	auto
 	width(
 		) const
@@ -43,6 +127,12 @@ public:
 		) const
 		-> GLuint;
 
+	auto
+	samples(
+		) const
+		-> GLuint;
+
+	// Sampleable colour, resolved when multisampled
 	auto
 	frame(
 		) const
@@ -53,10 +143,23 @@ public:
 		) const
 		-> Texture const&;
 
+	// Memory used by every attachment
+	auto
+	size_bytes(
+		) const
+		-> std::size_t;
+
 	auto
 	is_valid(
 		) const
 		-> bool;
+
+private:
+
+	auto
+	allocate(
+		)
+		-> void;
 };
 
 } // namespace ogl
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "framebuffer.hh"
+
+namespace ogl
+{
+
+// Hands out framebuffers by descriptor and keeps released ones for reuse, a
+// released target of the right formats is resized rather than reallocated
+class FramebufferPool
+{
+	struct Entry
+	{
+		std::unique_ptr<Framebuffer> framebuffer;
+		std::uint64_t                used   = 0U;
+		bool                         in_use = false;
+	};
+
+	std::vector<Entry> entries_;
+	std::uint64_t      frame_ = 0U;
+
+	// Statistics
+	std::uint64_t allocations_ = 0U;
+	std::uint64_t resizes_     = 0U;
+	std::uint64_t reuses_      = 0U;
+
+public:
+
+	// Frames a released framebuffer is kept before it is freed
+	std::uint64_t max_age = 3U;
+
+
+
+	// Framebuffer matching a descriptor, owned by the pool until released
+	auto
+	acquire(
+		Framebuffer::Descriptor const& descriptor
+		)
+		-> Framebuffer&;
+
+	auto
+	release(
+		Framebuffer const& framebuffer
+		)
+		-> void;
+
+	// Free framebuffers unused for max_age frames, call once per frame
+	auto
+	new_frame(
+		)
+		-> void;
+
+	// Free everything, framebuffers still acquired included
+	auto
+	clear(
+		)
+		-> void;
+
+
+
+	// Statistics
+	auto
+	size(
+		) const
+		-> std::size_t;
+
+	auto
+	size_bytes(
+		) const
+		-> std::size_t;
+
+	auto
+	allocations(
+		) const
+		-> std::uint64_t;
+
+	auto
+	resizes(
+		) const
+		-> std::uint64_t;
+
+	auto
+	reuses(
+		) const
+		-> std::uint64_t;
+};
+
+} // namespace ogl
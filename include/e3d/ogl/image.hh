@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace ogl
+{
+
+// 8 bit per channel pixels, rows from top to bottom
+struct Image
+{
+	std::uint32_t             width    = 0U;
+	std::uint32_t             height   = 0U;
+	std::uint32_t             channels = 4U;
+	std::vector<std::uint8_t> pixels;
+
+	auto
+	row(
+		std::uint32_t y
+		)
+		-> std::uint8_t*;
+
+	auto
+	row(
+		std::uint32_t y
+		) const
+		-> std::uint8_t const*;
+
+	// GL reads rows from the bottom
+	auto
+	flip_vertical(
+		)
+		-> void;
+
+	// Same pixels with 4 channels, grey is spread over rgb
+	auto
+	to_rgba(
+		) const
+		-> Image;
+};
+
+
+
+// Write binary PPM (alpha is dropped)
+auto
+write_ppm(
+	Image const&     image,
+	std::string_view filename
+	)
+	-> bool;
+
+// Write uncompressed PNG
+auto
+write_png(
+	Image const&     image,
+	std::string_view filename
+	)
+	-> bool;
+
+// Write by file extension (.png or .ppm)
+auto
+write_image(
+	Image const&     image,
+	std::string_view filename
+	)
+	-> bool;
+
+
+
+// Read binary PPM or PGM
+auto
+read_ppm(
+	std::string_view filename
+	)
+	-> std::optional<Image>;
+
+// Read TGA, uncompressed or run length encoded, grey or true colour
+auto
+read_tga(
+	std::string_view filename
+	)
+	-> std::optional<Image>;
+
+// Read PNG, 8 bit depth without interlacing
+auto
+read_png(
+	std::string_view filename
+	)
+	-> std::optional<Image>;
+
+// Read by file extension (.png, .tga, .ppm or .pgm)
+auto
+read_image(
+	std::string_view filename
+	)
+	-> std::optional<Image>;
+
+} // namespace ogl
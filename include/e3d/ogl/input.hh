@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/vec2.hpp>
+
+#include "renderer.hh"
+
+namespace ogl::input
+{
+
+// Types
+enum class Type : std::uint8_t
+{
+	Key,
+	Cursor,
+	Scroll
+};
+
+// Stamped when the window delivers it, offset is the cursor movement (y up)
+// or the scroll amount
+struct Event
+{
+	Type                 type   = Type::Key;
+	std::int32_t         key    = 0;
+	std::int32_t         action = 0;
+	glm::vec2            offset = glm::vec2(0.0F);
+	renderer::time_point time;
+};
+
+// Input as one tick saw it. Keys pressed and released within a tick show in
+// pressed and released even though down missed them
+struct State
+{
+	renderer::keyboard_t down     = renderer::keyboard_t{ false };
+	renderer::keyboard_t pressed  = renderer::keyboard_t{ false };
+	renderer::keyboard_t released = renderer::keyboard_t{ false };
+	glm::vec2            aim      = glm::vec2(0.0F);
+	float                scroll   = 0.0F;
+	std::size_t          events   = 0U;
+};
+
+
+
+// Events
+// Queue an event from the window thread, dropped (and counted) when the
+// consumer has fallen a full ring behind
+auto
+push(
+	Event const& event
+	)
+	-> void;
+
+// Apply every event stamped up to end, called once per tick by whichever
+// thread runs the fixed updates
+auto
+advance(
+	renderer::time_point end
+	)
+	-> State const&;
+
+// What the current tick sees
+auto
+state(
+	)
+	-> State const&;
+
+auto
+dropped(
+	)
+	-> std::uint64_t;
+
+} // namespace ogl::input
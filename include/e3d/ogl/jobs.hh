@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace ogl::jobs
+{
+
+// Types
+using job_function   = std::function<void()>;
+using range_function = std::function<void(std::size_t, std::size_t)>;
+
+class Scheduler;
+struct Job;
+
+// Counts unfinished jobs, other jobs can be held back until it reaches zero.
+// Wait on a counter before destroying it
+class Counter
+{
+	friend class Scheduler;
+
+	std::atomic<std::size_t> pending_ = 0U;
+
+	// Jobs waiting for this counter
+	std::mutex        mutex_;
+	std::vector<Job*> waiting_;
+
+public:
+
+	// Constructors
+	Counter(
+		) = default;
+
+	Counter(
+		Counter const&
+		)
+		= delete;
+
+	auto
+	operator=(
+		Counter const&
+		)
+		-> Counter&
+		= delete;
+};
+
+// Totals since start
+struct Stats
+{
+	std::size_t   workers  = 0U;
+	std::uint64_t executed = 0U;
+	std::uint64_t stolen   = 0U;
+};
+
+
+
+// Workers
+// Every worker owns a deque it pushes and pops at the bottom, idle workers
+// steal from the top of the others. The starting thread counts as worker
+// zero and helps while it waits. Zero workers means one per core less the
+// caller, jobs run inline until started
+auto
+start(
+	std::size_t workers = 0U
+	)
+	-> void;
+
+// Finish queued jobs and join the workers
+auto
+shutdown(
+	)
+	-> void;
+
+// Threads running jobs, the starting thread included
+auto
+concurrency(
+	)
+	-> std::size_t;
+
+
+
+// Jobs
+// Queue a job, counted by counter until it finishes and held back until
+// after reaches zero. Counters must outlive their jobs
+auto
+run(
+	job_function job,
+	Counter*     counter = nullptr,
+	Counter*     after   = nullptr
+	)
+	-> void;
+
+// Run queued jobs until the counter reaches zero
+auto
+wait(
+	Counter& counter
+	)
+	-> void;
+
+// Split [begin, end) into ranges of grain indices and run them across the
+// workers, returns once every range is done. Zero grain gives each thread
+// about four ranges
+auto
+parallel_for(
+	std::size_t           begin,
+	std::size_t           end,
+	std::size_t           grain,
+	range_function const& function
+	)
+	-> void;
+
+
+
+// Statistics
+auto
+stats(
+	)
+	-> Stats;
+
+} // namespace ogl::jobs
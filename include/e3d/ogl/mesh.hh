@@ -8,7 +8,9 @@
 #include <glm/glm.hpp>
 
 #include "../obj/obj.hh"
+#include "bounds.hh"
 #include "shader.hh"
+#include "transform.hh"
 
 using namespace std::string_view_literals;
 
@@ -45,6 +47,9 @@ private:
 	// Object representation
 	obj::Obj obj_;
 
+	// Transform before the last fixed update, for interpolation
+	Transform previous_;
+
 public:
 
 	// Details
@@ -79,6 +84,11 @@ public:
 		) const
 		-> std::uintmax_t;
 
+	auto
+	vertices(
+		) const
+		-> std::vector<obj::Vertex> const&;
+
 
 
 	// Buffers
@@ -110,6 +120,11 @@ public:
 		)
 		-> void;
 
+	auto
+	bounds(
+		) const
+		-> Aabb;
+
 	auto
 	reset_transforms(
 		)
@@ -134,6 +149,22 @@ public:
 		)
 		-> void;
 
+	auto
+	current_transform(
+		) const
+		-> Transform;
+
+	auto
+	previous_transform(
+		) const
+		-> Transform const&;
+
+	// Keep the current transform as the previous one, before a tick moves it
+	auto
+	save_transform(
+		)
+		-> void;
+
 
 
 	// Matrices
@@ -162,6 +193,19 @@ public:
 		) const
 		-> glm::mat3;
 
+	// Between the previous and current transform, alpha of the way along
+	auto
+	model_matrix(
+		float alpha
+		) const
+		-> glm::mat4;
+
+	auto
+	normal_matrix(
+		float alpha
+		) const
+		-> glm::mat3;
+
 
 
 	// Load model or file
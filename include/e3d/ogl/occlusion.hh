@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../obj/obj.hh"
+#include "bounds.hh"
+#include "mesh.hh"
+
+namespace ogl
+{
+
+// Occluders are rasterised on the CPU into a small depth buffer, only into
+// texels they cover entirely and at the furthest depth over each. That is
+// reduced into a hierarchical Z chain (every texel holds the furthest depth
+// beneath it) and boxes are tested against the few texels covering them. Depth is stored as
+// one over clip w, so it works with any depth convention and is the same for
+// reversed depth. Per frame: begin, add the large occluders, build, then test
+class OcclusionBuffer
+{
+public:
+
+	// Types
+	// Last frame, times in milliseconds
+	struct Stats
+	{
+		std::size_t occluders = 0U;
+		std::size_t triangles = 0U;
+		std::size_t tested    = 0U;
+		std::size_t culled    = 0U;
+		double      rasterise = 0.0;
+		double      build     = 0.0;
+		double      test      = 0.0;
+
+		// Everything culling cost, to weigh against the draws saved
+		auto
+		cost(
+			) const
+			-> double;
+	};
+
+private:
+
+	struct Level
+	{
+		std::size_t        width  = 0U;
+		std::size_t        height = 0U;
+		std::vector<float> depth;
+	};
+
+	// Level zero is the rasterised buffer, each next one half the size
+	std::vector<Level> levels_;
+	glm::mat4          view_projection_ = glm::mat4(1.0F);
+	Stats              stats_;
+
+public:
+
+	// Constructors
+	explicit
+	OcclusionBuffer(
+		std::size_t width  = 256U,
+		std::size_t height = 128U
+		);
+
+
+
+	// Occluders
+	// Clear for a new frame seen through a view-projection matrix
+	auto
+	begin(
+		glm::mat4 const& view_projection
+		)
+		-> void;
+
+	// Rasterise a mesh with its current transform, it should be solid and
+	// large on screen, anything it hides is culled
+	auto
+	add(
+		Mesh const& mesh
+		)
+		-> void;
+
+	// Rasterise a triangle list
+	auto
+	add(
+		std::vector<obj::Vertex> const& vertices,
+		glm::mat4                const& model
+		)
+		-> void;
+
+	// Reduce the rasterised depth into the hierarchy
+	auto
+	build(
+		)
+		-> void;
+
+
+
+	// Tests
+	auto
+	visible(
+		Aabb const& box
+		)
+		-> bool;
+
+	// Clear the flags of boxes that are hidden, flags already clear are
+	// skipped. Runs across the job workers
+	auto
+	test(
+		std::vector<Aabb>         const& boxes,
+		std::vector<std::uint8_t>&       inside
+		)
+		-> void;
+
+
+
+	// Details
+	auto
+	width(
+		) const
+		-> std::size_t;
+
+	auto
+	height(
+		) const
+		-> std::size_t;
+
+	// Rasterised depth, one over w and zero where nothing was drawn
+	auto
+	depth(
+		) const
+		-> std::vector<float> const&;
+
+	auto
+	stats(
+		) const
+		-> Stats const&;
+
+private:
+
+	auto
+	occluded(
+		Aabb const& box
+		) const
+		-> bool;
+
+	auto
+	rasterise(
+		glm::vec4 const& a,
+		glm::vec4 const& b,
+		glm::vec4 const& c
+		)
+		-> void;
+};
+
+} // namespace ogl
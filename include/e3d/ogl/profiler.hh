@@ -0,0 +1,192 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string_view>
+#include <vector>
+
+namespace ogl::profiler
+{
+
+// Types
+using clock = std::chrono::steady_clock;
+
+// Timeline a sample was measured on
+enum class Track
+{
+	Cpu,
+	Gpu
+};
+
+// Timed region, names must have static storage (string literals)
+struct Sample
+{
+	std::string_view name;
+	Track            track    = Track::Cpu;
+	std::uint32_t    depth    = 0U;
+	double           start    = 0.0;
+	double           duration = 0.0;
+};
+
+// Completed frame
+struct Frame
+{
+	std::uint64_t       index    = 0U;
+	double              start    = 0.0;
+	double              duration = 0.0;
+	std::vector<Sample> samples;
+};
+
+// Summary over the frame history, in milliseconds
+struct Stats
+{
+	double      average = 0.0;
+	double      p50     = 0.0;
+	double      p99     = 0.0;
+	double      maximum = 0.0;
+	std::size_t count   = 0U;
+};
+
+
+
+// Details
+bool        extern enabled;
+std::size_t extern history;
+
+
+
+// Frames
+auto
+new_frame(
+	)
+	-> void;
+
+auto
+frames(
+	)
+	-> std::deque<Frame> const&;
+
+
+
+// CPU timing
+auto
+begin(
+	std::string_view name
+	)
+	-> void;
+
+auto
+end(
+	)
+	-> void;
+
+// GPU timing, regions cannot be nested (GL_TIME_ELAPSED restriction)
+auto
+begin_gpu(
+	std::string_view name
+	)
+	-> void;
+
+auto
+end_gpu(
+	)
+	-> void;
+
+
+
+// Statistics
+auto
+frame_time(
+	)
+	-> Stats;
+
+auto
+stats(
+	std::string_view name,
+	Track            track = Track::Cpu
+	)
+	-> Stats;
+
+
+
+// Output as Chrome trace event JSON (chrome://tracing, Perfetto)
+auto
+write_trace(
+	std::string_view filename
+	)
+	-> bool;
+
+// Release GPU queries, needs a current context
+auto
+shutdown(
+	)
+	-> void;
+
+
+
+// Scoped CPU region
+class Scope
+{
+public:
+
+	explicit
+	Scope(
+		std::string_view name
+		)
+	{
+		begin(name);
+	}
+
+	~Scope(
+		)
+	{
+		end();
+	}
+
+	Scope(
+		Scope const&
+		)
+		= delete;
+
+	auto
+	operator=(
+		Scope const&
+		)
+		-> Scope&
+		= delete;
+};
+
+// Scoped GPU region
+class GpuScope
+{
+public:
+
+	explicit
+	GpuScope(
+		std::string_view name
+		)
+	{
+		begin_gpu(name);
+	}
+
+	~GpuScope(
+		)
+	{
+		end_gpu();
+	}
+
+	GpuScope(
+		GpuScope const&
+		)
+		= delete;
+
+	auto
+	operator=(
+		GpuScope const&
+		)
+		-> GpuScope&
+		= delete;
+};
+
+} // namespace ogl::profiler
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "framebuffer.hh"
+#include "framebuffer_pool.hh"
+
+namespace ogl
+{
+
+// Passes declare the targets they read and write, the graph culls passes
+// nobody needs, shares pooled framebuffers between transient targets whose
+// lifetimes do not overlap and issues the binds and clears. Rebuild it every
+// frame, names must have static storage (like profiler regions)
+class RenderGraph
+{
+public:
+
+	// Types
+	using Resource = std::size_t;
+
+	class Builder;
+	using setup_function   = std::function<void(Builder&)>;
+	using execute_function = std::function<void(RenderGraph const&)>;
+
+	// Last execution, bytes are what the transient targets occupied against
+	// what they would without aliasing
+	struct Stats
+	{
+		std::size_t passes          = 0U;
+		std::size_t culled          = 0U;
+		std::size_t framebuffers    = 0U;
+		std::size_t bytes           = 0U;
+		std::size_t unaliased_bytes = 0U;
+		double      compile         = 0.0;
+		double      execute         = 0.0;
+	};
+
+	// Declares what a pass touches
+	class Builder
+	{
+		friend class RenderGraph;
+
+		RenderGraph& graph_;
+		std::size_t  pass_;
+
+		Builder(
+			RenderGraph& graph,
+			std::size_t  pass
+			);
+
+	public:
+
+		// Bind the colour (or depth) of a target to a texture unit, depth
+		// only from targets that are not multisampled
+		auto
+		read(
+			Resource resource,
+			GLuint   unit,
+			bool     depth = false
+			)
+			-> void;
+
+		// Render into a target, cleared unless it already holds results
+		auto
+		write(
+			Resource resource,
+			bool     clear = true
+			)
+			-> void;
+
+		// Keep the pass even if nothing reads what it writes
+		auto
+		side_effect(
+			)
+			-> void;
+	};
+
+private:
+
+	struct Read
+	{
+		Resource resource = 0U;
+		GLuint   unit     = 0U;
+		bool     depth    = false;
+	};
+
+	struct Pass
+	{
+		std::string_view        name;
+		execute_function        execute;
+		std::vector<Read>       reads;
+		std::optional<Resource> target;
+		bool                    clear       = true;
+		bool                    side_effect = false;
+		bool                    culled      = false;
+	};
+
+	struct Node
+	{
+		std::string_view        name;
+		Framebuffer::Descriptor descriptor;
+		bool                    imported    = false;
+		Framebuffer const*      framebuffer = nullptr;
+
+		// Execution order of the first and last pass using it
+		std::size_t             first       = 0U;
+		std::size_t             last        = 0U;
+		bool                    used        = false;
+	};
+
+	FramebufferPool&  pool_;
+	std::vector<Pass> passes_;
+	std::vector<Node> nodes_;
+	bool              compiled_ = false;
+	Stats             stats_;
+
+public:
+
+	// Constructors
+	explicit
+	RenderGraph(
+		FramebufferPool& pool
+		);
+
+
+
+	// Resources
+	// Target owned by the graph for the frame
+	auto
+	create(
+		std::string_view               name,
+		Framebuffer::Descriptor const& descriptor
+		)
+		-> Resource;
+
+	// Target owned elsewhere, null for the window (or headless output),
+	// anything written to it is kept
+	auto
+	import(
+		std::string_view   name,
+		Framebuffer const* framebuffer = nullptr
+		)
+		-> Resource;
+
+	// Framebuffer behind a resource, valid while its passes execute
+	auto
+	get(
+		Resource resource
+		) const
+		-> Framebuffer const*;
+
+
+
+	// Passes
+	auto
+	add_pass(
+		std::string_view name,
+		setup_function   setup,
+		execute_function execute
+		)
+		-> void;
+
+	// Cull and work out target lifetimes, execute compiles if needed
+	auto
+	compile(
+		)
+		-> void;
+
+	auto
+	execute(
+		)
+		-> void;
+
+	// Drop every pass and resource for the next frame
+	auto
+	reset(
+		)
+		-> void;
+
+
+
+	// Statistics
+	auto
+	stats(
+		) const
+		-> Stats const&;
+};
+
+} // namespace ogl
@@ -3,6 +3,7 @@
 #include <array>
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <optional>
 #include <string>
 
@@ -15,6 +16,8 @@
 
 #include "camera.hh"
 #include "framebuffer.hh"
+#include "framebuffer_pool.hh"
+#include "image.hh"
 #include "mesh.hh"
 #include "texture.hh"
 
@@ -22,7 +25,7 @@ namespace ogl::renderer
 {
 
 // Types
-using clock      = std::chrono::high_resolution_clock;
+using clock      = std::chrono::steady_clock;
 using time_point = std::chrono::time_point<clock>;
 using duration   = std::chrono::duration<float>;
 
@@ -36,9 +39,18 @@ std::string    extern title;
 std::uintmax_t extern width;
 std::uintmax_t extern height;
 
+// Render offscreen without a window (EGL where available)
+bool           extern headless;
+
 // Camera
 Camera extern camera;
 
+// Render targets, reused across frames and resizes
+FramebufferPool extern framebuffers;
+
+// Called with the new framebuffer size when the window is resized
+std::function<void(GLuint, GLuint)> extern resize_function;
+
 
 
 // Details
@@ -63,11 +75,36 @@ clear_colour(
 	)
 	-> void;
 
+// Map near to one and infinity to zero for floating point depth precision,
+// the camera, depth test and clear value follow. Callable before start
+auto
+reverse_z(
+	bool enable
+	)
+	-> void;
+
 auto
 is_running(
 	)
 	-> bool;
 
+auto
+stop(
+	)
+	-> void;
+
+// Framebuffer standing in for the window when headless
+auto
+offscreen(
+	)
+	-> Framebuffer const*;
+
+// Framebuffer bound by the last call to target
+auto
+current_target(
+	)
+	-> GLuint;
+
 
 
 // Initialise
@@ -76,12 +113,25 @@ start(
 	)
 	-> void;
 
+// Poll events and refresh the title
 auto
 update(
 	time_point new_time
 	)
 	-> void;
 
+// Deliver window events, mouse movement collects until aim_camera
+auto
+poll(
+	)
+	-> void;
+
+// Turn and zoom the camera by the mouse input since the last call
+auto
+aim_camera(
+	)
+	-> void;
+
 
 
 // Render
@@ -114,6 +164,13 @@ display(
 	)
 	-> void;
 
+// Read back a framebuffer (or the current output) as an image
+auto
+capture(
+	Framebuffer const* framebuffer = nullptr
+	)
+	-> Image;
+
 
 
 // Shutdown
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace ogl
+{
+
+// Lock-free queue from one producer thread to one consumer thread, holding
+// at most Capacity - 1 values (a power of two)
+template<typename T, std::size_t Capacity>
+class RingBuffer
+{
+	static_assert((Capacity & (Capacity - 1U)) == 0U, "Ring buffer capacity must be a power of two");
+
+	std::array<T, Capacity> values_;
+	alignas(64) std::atomic<std::size_t> head_ = 0U;
+	alignas(64) std::atomic<std::size_t> tail_ = 0U;
+
+public:
+
+	// Producer, false when full
+	auto
+	push(
+		T const& value
+		)
+		-> bool
+	{
+		auto const tail = tail_.load(std::memory_order_relaxed);
+		auto const next = (tail + 1U) & (Capacity - 1U);
+		if (next == head_.load(std::memory_order_acquire))
+			return false;
+
+		values_[tail] = value;
+		tail_.store(next, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer, oldest value or null when empty
+	auto
+	front(
+		) const
+		-> T const*
+	{
+		auto const head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire))
+			return nullptr;
+
+		return &values_[head];
+	}
+
+	auto
+	pop(
+		)
+		-> void
+	{
+		auto const head = head_.load(std::memory_order_relaxed);
+		head_.store((head + 1U) & (Capacity - 1U), std::memory_order_release);
+	}
+};
+
+} // namespace ogl
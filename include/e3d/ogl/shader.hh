@@ -1,11 +1,14 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <typeinfo>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -17,6 +20,62 @@
 namespace ogl
 {
 
+// Uniform name hashed with 32 bit FNV-1a, at compile time wherever it is a
+// constant expression
+struct Uniform
+{
+	std::uint32_t    hash = 0U;
+	std::string_view name;
+
+	constexpr
+	Uniform(
+		std::string_view const name
+		) :
+		hash(hash_name(name)),
+		name(name)
+	{}
+
+	constexpr
+	Uniform(
+		char const* const name
+		) :
+		Uniform(std::string_view(name))
+	{}
+
+	Uniform(
+		std::string const& name
+		) :
+		Uniform(std::string_view(name))
+	{}
+
+	// Zero marks an empty slot in the lookup table
+	auto static constexpr
+	hash_name(
+		std::string_view const name
+		)
+		-> std::uint32_t
+	{
+		auto hash = std::uint32_t(2166136261U);
+		for (auto const c : name)
+			hash = (hash ^ std::uint8_t(c)) * 16777619U;
+		return hash != 0U ? hash : 1U;
+	}
+};
+
+// Literal uniform, e.g. "model"_uniform. It is only guaranteed to hash at
+// compile time in a constant expression (such as a constexpr variable)
+constexpr auto
+operator""_uniform(
+	char const* const name,
+	std::size_t const size
+	)
+	-> Uniform
+{
+	return Uniform(std::string_view(name, size));
+}
+
+
+
 class Shader
 {
 public:
@@ -34,21 +93,71 @@ public:
 	// Shader code as array of source type and string to use
 	using code_array = std::vector<std::pair<CodeType, std::string_view>>;
 
+	// One bit per define returned by Shader::define
+	using define_mask = std::uint64_t;
+
 private:
 
-	using uniform_cache = std::unordered_map<std::string, GLint>;
+	// Active uniform names and locations, reflected after linking
+	using uniform_cache = std::vector<std::pair<std::string, GLint>>;
+
+	// Open addressed by name hash, power of two size. Names are compared so
+	// colliding hashes cannot share a location
+	struct UniformSlot
+	{
+		std::uint32_t hash     = 0U;
+		GLint         location = -1;
+		std::string   name;
+	};
 
 
 
 	// Details
 	GLuint                program_ = 0;
 	std::vector<GLuint>   shaders_;
-	uniform_cache mutable uniforms_;
+	uniform_cache            uniforms_;
+
+	// Reflected uniforms, and names GL resolved on a miss (array elements,
+	// or -1 for inactive ones) so it is asked only once per name
+	std::vector<UniformSlot> mutable uniform_table_;
+	std::size_t              mutable uniform_count_ = 0U;
+
+	// Stage sources, compiled on build unless the program is cached, and
+	// their hash (kept up to date whenever they change)
+	std::vector<std::pair<GLenum, std::string>> sources_;
+	std::uint64_t                               source_hash_ = 0U;
+
+	// Code each source was made from, files are read again on reload
+	std::vector<std::vector<std::pair<CodeType, std::string>>> origins_;
+
+	// Program submitted to the driver but not yet checked, with its stages
+	GLuint                                pending_   = 0;
+	std::vector<GLuint>                   staged_;
+	std::uint64_t                         key_       = 0;
+	bool                                  cached_    = false;
+	bool                                  caching_   = false;
+	std::chrono::steady_clock::time_point submitted_;
+	double                                time_      = 0.0;
+
+	// Permutation and the source hash it was built from
+	struct Variant
+	{
+		std::uint64_t            source = 0U;
+		std::vector<std::string> defines;
+		std::unique_ptr<Shader>  shader;
+	};
+
+	// Defines by bit, and the permutations built from them so far
+	std::vector<std::string>       defines_;
+	std::map<define_mask, Variant> variants_;
 
 public:
 
 	std::string name;
 
+	// Program binaries are kept here, empty disables the cache
+	std::string static cache_directory;
+
 
 
 	// Constructors
@@ -107,9 +216,10 @@ public:
 		) const
 		-> bool;
 
+	// Location of an active uniform, -1 (ignored by GL) otherwise
 	auto
 	uniform_location(
-		std::string_view uniform
+		Uniform uniform
 		) const
 		-> GLint;
 
@@ -134,11 +244,36 @@ public:
 
 
 	// Management
+	// Link the program, loading a cached binary when one matches
 	auto
 	build(
 		)
 		-> void;
 
+	// Start compiling and linking without waiting for the driver
+	auto
+	submit(
+		)
+		-> void;
+
+	// Whether finish would return without blocking
+	auto
+	is_ready(
+		) const
+		-> bool;
+
+	// Check the submitted program and report errors, blocks if not ready
+	auto
+	finish(
+		)
+		-> bool;
+
+	// Milliseconds from submit to finish
+	auto
+	build_time(
+		) const
+		-> double;
+
 	auto
 	use(
 		) const
@@ -149,14 +284,116 @@ public:
 		)
 		-> void;
 
+
+
+	// Variants
+	// Register a define ("NAME" or "NAME value"), returns its bit
+	auto
+	define(
+		std::string_view definition
+		)
+		-> define_mask;
+
+	// Permutation with the masked defines, built on first use
+	auto
+	variant(
+		define_mask mask
+		)
+		-> Shader&;
+
+	auto
+	variant_count(
+		) const
+		-> std::size_t;
+
+
+
+	// Reloading
+	// Files the sources were read from
+	auto
+	files(
+		) const
+		-> std::vector<std::string>;
+
+	// Read files again and resubmit changed programs, the old ones stay in
+	// use until the new ones link
+	auto
+	reload(
+		)
+		-> bool;
+
+	// Finish reloads that are ready, true once none are pending
+	auto
+	poll(
+		)
+		-> bool;
+
 private:
 
-	// Uniform caching
+	// Uniform reflection
 	auto
-	uniform_location(
-		std::string_view uniform
+	reflect(
+		)
+		-> void;
+
+	// Add a name to the table, growing it to stay at most half full
+	auto
+	insert_uniform(
+		std::uint32_t    hash,
+		std::string_view uniform,
+		GLint            location
 		) const
-		-> GLint;
+		-> void;
+
+
+
+	// Hash every stage source into source_hash_
+	auto
+	hash_sources(
+		)
+		-> void;
+
+	// Reloads skip the binary cache, its key, lookup and store all block the
+	// render thread and an edited shader rarely matches a stored binary
+	auto
+	submit(
+		bool use_cache
+		)
+		-> void;
+
+	// Drop any program in flight and submit again, uncached
+	auto
+	resubmit(
+		)
+		-> void;
+
+	// Point a permutation at the current sources
+	auto
+	update_variant(
+		Variant& variant
+		) const
+		-> void;
+
+
+
+	// Program binary cache
+	auto
+	cache_key(
+		) const
+		-> std::uint64_t;
+
+	auto
+	load_binary(
+		std::uint64_t key
+		) const
+		-> std::optional<GLuint>;
+
+	auto
+	save_binary(
+		std::uint64_t key,
+		GLuint        program
+		) const
+		-> void;
 
 
 
@@ -166,12 +403,19 @@ private:
 		GLenum           type,
 		std::string_view code
 		) const
-		-> std::optional<GLuint>;
+		-> GLuint;
 
 	auto
 	link(
 		) const
-		-> std::optional<GLuint>;
+		-> GLuint;
+
+	// Log stage and program errors, true if the program linked
+	auto
+	check(
+		GLuint program
+		) const
+		-> bool;
 
 public:
 
@@ -179,7 +423,7 @@ public:
 	template<typename T>
 	auto
 	bind(
-		std::string_view const uniform,
+		Uniform          const uniform,
 		T                const value
 		) const
 		-> void
@@ -197,7 +441,7 @@ public:
 			glUniform1d(location, value);
 		else
 			std::cerr << "ERROR: Cannot bind uniform " <<
-				uniform << " to value of type " <<
+				uniform.name << " to value of type " <<
 				typeid(T).name() << " in shader " <<
 				name << std::endl;
 	}
@@ -206,7 +450,7 @@ public:
 	template<typename T>
 	auto
 	bind(
-		std::string_view const uniform,
+		Uniform          const uniform,
 		T const*         const value,
 		GLsizei          const count
 		) const
@@ -225,7 +469,7 @@ public:
 			glUniform1dv(location, count, value);
 		else
 			std::cerr << "ERROR: Cannot bind uniform " <<
-				uniform << " to value of type " <<
+				uniform.name << " to value of type " <<
 				typeid(T).name() << " in shader " <<
 				name << std::endl;
 	}
@@ -234,7 +478,7 @@ public:
 	template<glm::length_t L, typename T>
 	auto
 	bind(
-		std::string_view const uniform,
+		Uniform          const uniform,
 		glm::vec<L, T>   const value,
 		GLsizei          const count = 1
 		) const
@@ -255,7 +499,7 @@ public:
 				glUniform4iv(location, count, glm::value_ptr(value));
 			else
 				std::cerr << "ERROR: Cannot bind uniform " <<
-					uniform << " to vector of length " <<
+					uniform.name << " to vector of length " <<
 					L << " in shader " <<
 					name << std::endl;
 		}
@@ -271,7 +515,7 @@ public:
 				glUniform4uiv(location, count, glm::value_ptr(value));
 			else
 				std::cerr << "ERROR: Cannot bind uniform " <<
-					uniform << " to vector of length " <<
+					uniform.name << " to vector of length " <<
 					L << " in shader " <<
 					name << std::endl;
 		}
@@ -287,7 +531,7 @@ public:
 				glUniform4fv(location, count, glm::value_ptr(value));
 			else
 				std::cerr << "ERROR: Cannot bind uniform " <<
-					uniform << " to vector of length " <<
+					uniform.name << " to vector of length " <<
 					L << " in shader " <<
 					name << std::endl;
 		}
@@ -303,13 +547,13 @@ public:
 				glUniform4dv(location, count, glm::value_ptr(value));
 			else
 				std::cerr << "ERROR: Cannot bind uniform " <<
-					uniform << " to vector of length " <<
+					uniform.name << " to vector of length " <<
 					L << " in shader " <<
 					name << std::endl;
 		}
 		else
 			std::cerr << "ERROR: Cannot bind uniform " <<
-				uniform << " to value of type " <<
+				uniform.name << " to value of type " <<
 				typeid(T).name() << " in shader " <<
 				name << std::endl;
 	}
@@ -318,7 +562,7 @@ public:
 	template<glm::length_t C, glm::length_t R, typename T>
 	auto
 	bind(
-		std::string_view  const uniform,
+		Uniform           const uniform,
 		glm::mat<C, R, T> const value,
 		GLsizei           const count     = 1,
 		GLboolean         const transpose = GL_FALSE
@@ -350,7 +594,7 @@ public:
 				glUniformMatrix4fv(location, count, transpose, glm::value_ptr(value));
 			else
 				std::cerr << "ERROR: Cannot bind uniform " <<
-					uniform << " to matrix size " <<
+					uniform.name << " to matrix size " <<
 					C << "x" << R << " in shader " <<
 					name << std::endl;
 		}
@@ -376,13 +620,13 @@ public:
 				glUniformMatrix4dv(location, count, transpose, glm::value_ptr(value));
 			else
 				std::cerr << "ERROR: Cannot bind uniform " <<
-				uniform << " to matrix size " <<
+				uniform.name << " to matrix size " <<
 				C << "x" << R << " in shader " <<
 				name << std::endl;
 		}
 		else
 			std::cerr << "ERROR: Cannot bind uniform " <<
-				uniform << " to value of type " <<
+				uniform.name << " to value of type " <<
 				typeid(T).name() << " in shader " <<
 				name << std::endl;
 	}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "shader.hh"
+
+namespace ogl
+{
+
+// Named shaders built together so the driver can compile them in parallel
+class ShaderLibrary
+{
+	std::unordered_map<std::string, std::shared_ptr<Shader>> shaders_;
+
+	// Created since the last submit, and submitted but not yet finished
+	std::vector<std::shared_ptr<Shader>> queued_;
+	std::vector<std::shared_ptr<Shader>> pending_;
+
+	// Wall time of the last build
+	std::chrono::steady_clock::time_point start_;
+	double                                time_ = 0.0;
+
+public:
+
+	// Create a named shader, add its code and then build
+	auto
+	create(
+		std::string const& name
+		)
+		-> std::shared_ptr<Shader>;
+
+	auto
+	get(
+		std::string_view name
+		) const
+		-> std::shared_ptr<Shader>;
+
+
+
+	// Submit every unbuilt shader, then finish them as they complete
+	auto
+	build(
+		)
+		-> bool;
+
+	// Start building without waiting, poll once per frame
+	auto
+	submit(
+		)
+		-> void;
+
+	// Finish the shaders that are ready, true once none are left
+	auto
+	poll(
+		)
+		-> bool;
+
+
+
+	// Statistics
+	auto
+	size(
+		) const
+		-> std::size_t;
+
+	// Milliseconds for the last build
+	auto
+	build_time(
+		) const
+		-> double;
+
+	// Print every shader's latency from submit to finish
+	auto
+	report(
+		) const
+		-> void;
+};
+
+} // namespace ogl
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+namespace ogl::state
+{
+
+// Types
+// GL calls made through the cache, and those it found redundant
+struct Counters
+{
+	std::uint64_t issued  = 0U;
+	std::uint64_t skipped = 0U;
+};
+
+
+
+// Frames
+// Forget everything, for after context creation or foreign GL code
+auto
+invalidate(
+	)
+	-> void;
+
+// Start counting a new frame
+auto
+new_frame(
+	)
+	-> void;
+
+// Counters of the last complete frame
+auto
+counters(
+	)
+	-> Counters;
+
+
+
+// Objects
+auto
+use_program(
+	GLuint program
+	)
+	-> void;
+
+auto
+current_program(
+	)
+	-> GLuint;
+
+auto
+bind_vertex_array(
+	GLuint vertex_array
+	)
+	-> void;
+
+// GL_FRAMEBUFFER binds both draw and read
+auto
+bind_framebuffer(
+	GLenum target,
+	GLuint framebuffer
+	)
+	-> void;
+
+auto
+current_framebuffer(
+	GLenum target
+	)
+	-> GLuint;
+
+// Buffers owned by a vertex array (element arrays) are not tracked
+auto
+bind_buffer(
+	GLenum target,
+	GLuint buffer
+	)
+	-> void;
+
+auto
+active_texture(
+	GLuint unit
+	)
+	-> void;
+
+// Leaves the active unit alone when the texture is already bound, only for
+// sampling
+auto
+bind_texture(
+	GLuint unit,
+	GLenum target,
+	GLuint texture
+	)
+	-> void;
+
+// Bind and make the unit active, for the glTex* calls that follow
+auto
+bind_texture_for_edit(
+	GLuint unit,
+	GLenum target,
+	GLuint texture
+	)
+	-> void;
+
+
+
+// Deleted names can be reused, so drop them from the cache
+auto
+release_program(
+	GLuint program
+	)
+	-> void;
+
+auto
+release_vertex_array(
+	GLuint vertex_array
+	)
+	-> void;
+
+auto
+release_framebuffer(
+	GLuint framebuffer
+	)
+	-> void;
+
+auto
+release_buffer(
+	GLuint buffer
+	)
+	-> void;
+
+auto
+release_texture(
+	GLuint texture
+	)
+	-> void;
+
+
+
+// Fixed function state
+auto
+enable(
+	GLenum capability,
+	bool   enabled = true
+	)
+	-> void;
+
+auto
+disable(
+	GLenum capability
+	)
+	-> void;
+
+auto
+blend_func(
+	GLenum source,
+	GLenum destination
+	)
+	-> void;
+
+auto
+depth_func(
+	GLenum function
+	)
+	-> void;
+
+auto
+depth_mask(
+	bool write
+	)
+	-> void;
+
+auto
+viewport(
+	GLint   x,
+	GLint   y,
+	GLsizei width,
+	GLsizei height
+	)
+	-> void;
+
+} // namespace ogl::state
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 #define GLEW_STATIC
 #include <GL/glew.h>
 
@@ -8,19 +10,53 @@ namespace ogl
 
 class Texture
 {
-	GLuint id_;
-	GLuint width_;
-	GLuint height_;
-	GLenum type_;
+	friend class Framebuffer;
+	friend class TextureAtlas;
+	friend class TextureLoader;
+
+	GLuint      id_         = 0U;
+	GLuint      width_      = 0U;
+	GLuint      height_     = 0U;
+	GLenum      type_       = GL_TEXTURE_2D;
+	GLenum      format_     = GL_RGBA8;
+	GLuint      levels_     = 1U;
+	std::size_t size_bytes_ = 0U;
+	bool        ready_      = true;
 
 public:
 
 	// Constructors
+	// Empty texture, filled in by a loader
+	Texture(
+		);
+
 	Texture(
 		GLuint width,
 		GLuint height
 		);
 
+	Texture(
+		Texture const&
+		)
+		= delete;
+
+	Texture(
+		Texture&& other
+		) noexcept;
+
+	auto
+	operator=(
+		Texture const&
+		)
+		-> Texture&
+		= delete;
+
+	auto
+	operator=(
+		Texture&& other
+		) noexcept
+		-> Texture&;
+
 	~Texture(
 		);
 
@@ -44,6 +80,30 @@ public:
 	type(
 		) const
 		-> GLenum;
+
+	// Internal format
+	auto
+	format(
+		) const
+		-> GLenum;
+
+	// Mip levels
+	auto
+	levels(
+		) const
+		-> GLuint;
+
+	// Memory used by every level
+	auto
+	size_bytes(
+		) const
+		-> std::size_t;
+
+	// False while a loader is still uploading levels
+	auto
+	is_ready(
+		) const
+		-> bool;
 };
 
 } // namespace ogl
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "../obj/obj.hh"
+
+#include "texture.hh"
+
+namespace ogl
+{
+
+// Decodes images on worker threads and streams them to GL within a per frame
+// budget, mip chains are built on the CPU and optionally block compressed
+class TextureLoader
+{
+public:
+
+	// Types
+	// Totals for a set of textures (usually a material)
+	struct Stats
+	{
+		std::size_t textures = 0U;
+		std::size_t bytes    = 0U;
+		double      decode   = 0.0;
+		double      upload   = 0.0;
+	};
+
+private:
+
+	struct Level
+	{
+		GLuint                    width  = 0U;
+		GLuint                    height = 0U;
+		std::vector<std::uint8_t> data;
+	};
+
+	struct Job
+	{
+		std::shared_ptr<Texture> texture;
+		std::string              path;
+		std::string              set;
+		bool                     compress = false;
+
+		// Filled in by the worker
+		GLenum                   format   = GL_RGBA8;
+		std::vector<Level>       levels;
+		double                   decode   = 0.0;
+		bool                     failed   = false;
+		bool                     cached   = false;
+	};
+
+
+
+	// Details
+	GLuint buffer_     = 0U;
+	bool   compressed_ = false;
+
+	// Textures by path, so shared maps load once
+	std::unordered_map<std::string, std::weak_ptr<Texture>> loaded_;
+
+	// Worker threads
+	std::vector<std::thread> threads_;
+	std::mutex               mutex_;
+	std::condition_variable  condition_;
+	std::deque<Job>          requests_;
+	std::deque<Job>          decoded_;
+	std::size_t              working_  = 0U;
+	bool                     stopping_ = false;
+
+	// Uploads in progress, only touched on the GL thread
+	std::deque<Job>          uploads_;
+	std::size_t              next_level_ = 0U;
+
+	// Statistics
+	std::map<std::string, Stats> stats_;
+
+public:
+
+	// Bytes uploaded per update, at least one level is always uploaded
+	std::size_t upload_budget = 8U << 20U;
+
+	// Transcode to BC1 (opaque) or BC3 (with alpha) when supported
+	bool compress = true;
+
+	// Decoded mip chains are kept here, empty disables the cache
+	std::string cache_directory = "texture_cache";
+
+
+
+	// Constructors
+	// Threads default to the hardware concurrency less the render thread
+	explicit
+	TextureLoader(
+		unsigned threads = 0U
+		);
+
+	TextureLoader(
+		TextureLoader const&
+		)
+		= delete;
+
+	auto
+	operator=(
+		TextureLoader const&
+		)
+		-> TextureLoader&
+		= delete;
+
+	~TextureLoader(
+		);
+
+
+
+	// Queue an image, the texture is usable once is_ready() returns true
+	auto
+	load(
+		std::string const& path,
+		std::string const& set = ""
+		)
+		-> std::shared_ptr<Texture>;
+
+	// Queue every map of a material, relative to a directory, keyed by map
+	// name (map_Kd, map_Ka, ...)
+	auto
+	load_material(
+		obj::Material const& material,
+		std::string const&   directory
+		)
+		-> std::map<std::string, std::shared_ptr<Texture>>;
+
+	// Upload decoded levels within the budget, call once per frame
+	auto
+	update(
+		)
+		-> void;
+
+	// Block until every queued texture has been uploaded
+	auto
+	flush(
+		)
+		-> void;
+
+	// Textures not yet ready
+	auto
+	pending(
+		)
+		-> std::size_t;
+
+
+
+	// Statistics
+	auto
+	stats(
+		) const
+		-> std::map<std::string, Stats> const&;
+
+	auto
+	report(
+		) const
+		-> void;
+
+private:
+
+	auto
+	run(
+		)
+		-> void;
+
+	auto
+	decode(
+		Job& job
+		) const
+		-> void;
+
+	auto
+	upload(
+		Job&        job,
+		std::size_t level
+		)
+		-> std::size_t;
+};
+
+} // namespace ogl
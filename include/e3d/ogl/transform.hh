@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace ogl
+{
+
+// Position, orientation and scale of a simulated object
+struct Transform
+{
+	glm::vec3 position    = glm::vec3(0.0F);
+	glm::quat orientation = glm::quat(1.0F, 0.0F, 0.0F, 0.0F);
+	glm::vec3 scale       = glm::vec3(1.0F);
+
+	auto
+	matrix(
+		) const
+		-> glm::mat4;
+
+	// Inverse transpose of the upper 3x3 of matrix, as compute_matrices
+	auto
+	normal_matrix(
+		) const
+		-> glm::mat3;
+};
+
+// Transforms split into one array per component, so matrices for many
+// objects are computed several at a time
+struct TransformBatch
+{
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+
+	// Unit quaternions
+	std::vector<float> qx;
+	std::vector<float> qy;
+	std::vector<float> qz;
+	std::vector<float> qw;
+
+	std::vector<float> sx;
+	std::vector<float> sy;
+	std::vector<float> sz;
+
+	auto
+	size(
+		) const
+		-> std::size_t;
+
+	auto
+	resize(
+		std::size_t size
+		)
+		-> void;
+
+	auto
+	set(
+		std::size_t      index,
+		Transform const& transform
+		)
+		-> void;
+
+	auto
+	push_back(
+		Transform const& transform
+		)
+		-> void;
+};
+
+// Simulation state handed from fixed updates to rendering
+struct Snapshot
+{
+	std::uint64_t          tick = 0U;
+	double                 time = 0.0;
+	std::vector<Transform> transforms;
+};
+
+
+
+// Blend two transforms, orientation takes the shortest arc
+auto
+interpolate(
+	Transform const& from,
+	Transform const& to,
+	float            alpha
+	)
+	-> Transform;
+
+// Blend matching transforms, objects only in the newer snapshot are copied
+auto
+interpolate(
+	Snapshot const&         from,
+	Snapshot const&         to,
+	float                   alpha,
+	std::vector<Transform>& result
+	)
+	-> void;
+
+
+
+// Model matrices (and normal matrices, the inverse transpose of their upper
+// 3x3, unless null) for a whole batch. Composes rotation and scale straight
+// from the components, AVX or SSE do eight or four transforms at a time
+// when the compiler targets them. Rotation is orthonormal and scale
+// diagonal, so the inverse transpose of R * S is R * S^-1 and no matrix is
+// ever inverted
+auto
+compute_matrices(
+	TransformBatch const& batch,
+	glm::mat4*            models,
+	glm::mat3*            normals = nullptr
+	)
+	-> void;
+
+} // namespace ogl
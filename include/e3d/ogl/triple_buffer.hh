@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace ogl
+{
+
+// Lock-free hand-off of the latest value from one writer thread to one reader
+// thread, neither ever waits and the reader always sees a complete value
+template<typename T>
+class TripleBuffer
+{
+	// The middle index carries a flag while it holds an unread value
+	auto static constexpr fresh_ = std::uint8_t(4U);
+
+	std::array<T, 3>          buffers_;
+	std::atomic<std::uint8_t> middle_ = 1U;
+	std::uint8_t              write_  = 0U;
+	std::uint8_t              read_   = 2U;
+
+public:
+
+	// Writer, fill then publish
+	auto
+	write(
+		)
+		-> T&
+	{
+		return buffers_[write_];
+	}
+
+	auto
+	publish(
+		)
+		-> void
+	{
+		write_ = middle_.exchange(write_ | fresh_, std::memory_order_acq_rel) & 3U;
+	}
+
+	// Reader, returns whether read() changed
+	auto
+	update(
+		)
+		-> bool
+	{
+		if (!(middle_.load(std::memory_order_acquire) & fresh_))
+			return false;
+
+		read_ = middle_.exchange(read_, std::memory_order_acq_rel) & 3U;
+		return true;
+	}
+
+	auto
+	read(
+		) const
+		-> T const&
+	{
+		return buffers_[read_];
+	}
+};
+
+} // namespace ogl
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shader.hh"
+
+namespace ogl
+{
+
+// Reloads shaders when their files change (inotify on Linux, polling elsewhere)
+class ShaderWatcher
+{
+	// Shaders by the absolute path of each file they read
+	std::unordered_map<std::string, std::vector<std::weak_ptr<Shader>>> files_;
+
+	// Reloads submitted but not yet linked
+	std::vector<std::shared_ptr<Shader>> reloading_;
+
+#ifdef __linux__
+	int                                   fd_ = -1;
+	std::unordered_map<int, std::string>  directories_;
+#else
+	std::unordered_map<std::string, std::filesystem::file_time_type> times_;
+	std::filesystem::file_time_type::clock::time_point               checked_;
+#endif
+
+	// Statistics
+	std::uint64_t reloads_     = 0U;
+	double        reload_time_ = 0.0;
+
+public:
+
+	// Constructors
+	ShaderWatcher(
+		);
+
+	ShaderWatcher(
+		ShaderWatcher const&
+		)
+		= delete;
+
+	auto
+	operator=(
+		ShaderWatcher const&
+		)
+		-> ShaderWatcher&
+		= delete;
+
+	~ShaderWatcher(
+		);
+
+
+
+	// Watch every file a shader was added from
+	auto
+	watch(
+		std::shared_ptr<Shader> const& shader
+		)
+		-> void;
+
+	// Resubmit changed shaders and swap in the ones that have linked, call
+	// once per frame
+	auto
+	poll(
+		)
+		-> void;
+
+
+
+	// Statistics
+	auto
+	is_reloading(
+		) const
+		-> bool;
+
+	auto
+	reloads(
+		) const
+		-> std::uint64_t;
+
+	// Longest poll during the last reload in milliseconds, the frame time
+	// a reload costs the render thread
+	auto
+	reload_time(
+		) const
+		-> double;
+};
+
+} // namespace ogl
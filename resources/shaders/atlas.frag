@@ -0,0 +1,23 @@
+#version 410
+
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec3 in_normal;
+layout (location = 2) in vec2 in_uv;
+layout (location = 3) flat in uint in_layer;
+
+out vec4 out_colour;
+
+// Every material of the batch, one layer each (see TextureAtlas)
+uniform sampler2DArray atlas;
+
+// Lambert shading of the atlas texture with a directional light
+void main()
+{
+	vec4 albedo = texture(atlas, vec3(in_uv, float(in_layer)));
+
+	vec3  light_colour    = normalize(vec3(0.5F, 0.4F, 0.3F));
+	vec3  light_direction = normalize(vec3(1.0F, 2.0F, 3.0F));
+	float diffuse         = max(dot(light_direction, normalize(in_normal)), 0.0F);
+
+	out_colour = vec4(albedo.rgb * light_colour * (0.5F + diffuse), albedo.a);
+}
@@ -0,0 +1,25 @@
+#version 410
+
+// Batched vertices are already in world space
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec3 in_normal;
+layout (location = 2) in vec2 in_uv;
+layout (location = 3) in uint in_layer;
+
+layout (location = 0) out vec3 out_position;
+layout (location = 1) out vec3 out_normal;
+layout (location = 2) out vec2 out_uv;
+layout (location = 3) flat out uint out_layer;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+	gl_Position = projection * view * vec4(in_position, 1.0F);
+
+	out_position = in_position;
+	out_normal   = normalize(in_normal);
+	out_uv       = in_uv;
+	out_layer    = in_layer;
+}
@@ -16,13 +16,13 @@ uniform mat4 projection;
 
 void main()
 {
-	mat4 normal = inverse(rotate * scale);
-	mat4 model  = translate * rotate * scale;
-	mat4 mvp    = projection * view * model;
+	vec3 inverse_scale = 1.0F / vec3(scale[0][0], scale[1][1], scale[2][2]);
+	mat4 model         = translate * rotate * scale;
+	mat4 mvp           = projection * view * model;
 
 	gl_Position = mvp * vec4(in_position, 1.0F);
 
 	out_position = vec3(model  * vec4(in_position, 1.0F));
-	out_normal   = normalize(in_normal * mat3(normal));
+	out_normal   = normalize(mat3(rotate) * (in_normal * inverse_scale));
 	out_uv       = in_uv;
 }
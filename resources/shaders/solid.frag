@@ -0,0 +1,13 @@
+#version 410 core
+
+// Variants set COLOUR, e.g. "COLOUR vec4(1.0, 0.0, 0.0, 1.0)" for red
+#ifndef COLOUR
+#define COLOUR vec4(0.5, 0.5, 0.5, 1.0)
+#endif
+
+layout (location = 0) out vec4 out_colour;
+
+void main()
+{
+	out_colour = COLOUR;
+}
@@ -1,6 +1,19 @@
 #include <e3d/ogl/app.hh>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include <e3d/ogl/input.hh>
+#include <e3d/ogl/jobs.hh>
+#include <e3d/ogl/profiler.hh>
 #include <e3d/ogl/renderer.hh>
+#include <e3d/ogl/state.hh>
+#include <e3d/ogl/triple_buffer.hh>
 
 
 
@@ -15,6 +28,201 @@ std::function<void(float)> fixed_update_function = [](float){};
 std::function<void()>      render_function       = [](){};
 std::function<void()>      close_function        = [](){};
 
+std::function<void(Snapshot&)> publish_function = [](Snapshot&){};
+
+
+
+// Timing
+float tick_rate      = 1.0F / 60.0F;
+float max_frame_rate = 0.0F;
+float fixed_frame    = 0.0F;
+
+// Tick rate as last read by the render thread, guarded by the simulation
+// mutex
+auto static tick_rate_ = 1.0F / 60.0F;
+
+
+
+// Input
+bool late_latch = false;
+
+
+
+// Threading
+std::size_t workers  = 0U;
+bool        threaded = false;
+
+// Whether this run actually simulates on its own thread
+auto static threading_ = false;
+
+// Snapshot as handed over with the tick before it, stamped when it was
+// finished and with the real time until the next one is due. Renders slower
+// than the simulation skip ticks, the pair keeps interpolation between
+// consecutive ones
+struct Published
+{
+	Snapshot                    previous;
+	Snapshot                    snapshot;
+	profiler::clock::time_point time;
+	profiler::clock::duration   interval;
+};
+
+auto static snapshots_  = TripleBuffer<Published>();
+auto static stopping_   = std::atomic<bool>(false);
+auto static simulation_ = std::thread();
+
+// Render side
+auto static previous_  = Snapshot();
+auto static current_   = Snapshot();
+auto static published_ = profiler::clock::time_point();
+auto static interval_  = profiler::clock::duration(1);
+auto static alpha_     = 1.0F;
+
+// Meshes interpolated between ticks
+auto static tracked_ = std::vector<Mesh*>();
+
+
+
+// Statistics
+struct Window
+{
+	profiler::clock::time_point start;
+	double                      total   = 0.0;
+	double                      maximum = 0.0;
+	std::uint64_t               count   = 0U;
+	LoopStats                   last;
+};
+
+auto static render_window_     = Window();
+auto static simulation_window_ = Window();
+auto static simulation_mutex_  = std::mutex();
+
+auto static
+record(
+	Window&                           window,
+	profiler::clock::time_point const start,
+	profiler::clock::time_point const end
+	)
+	-> void
+{
+	if (window.start == profiler::clock::time_point())
+		window.start = start;
+
+	auto const ms = std::chrono::duration<double, std::milli>(end - start).count();
+	window.total  += ms;
+	window.maximum = std::max(window.maximum, ms);
+	++window.count;
+
+	if (end - window.start < std::chrono::seconds(1))
+		return;
+
+	window.last.average = window.total / double(window.count);
+	window.last.maximum = window.maximum;
+	window.last.count   = window.count;
+	window              = Window{ end, 0.0, 0.0, 0U, window.last };
+}
+
+
+
+// Catch-up
+std::uint32_t max_substeps = 5U;
+Overrun       overrun      = Overrun::Drop;
+float         tick_budget  = 0.5F;
+
+// Longest adaptive tick in base ticks, slowest dilation and how fast it
+// eases back per second
+auto static constexpr max_interval_   = 4U;
+auto static constexpr min_time_scale_ = 0.25F;
+auto static constexpr recovery_       = 0.5F;
+
+// Settings as last read by the render thread, guarded by the simulation
+// mutex like tick_rate_
+auto static max_substeps_ = 5U;
+auto static overrun_      = Overrun::Drop;
+auto static tick_budget_  = 0.5F;
+auto static fixed_frame_  = 0.0F;
+
+// Guarded by the simulation mutex
+auto static steps_     = StepStats();
+auto static evaluated_ = profiler::clock::time_point();
+
+// Copy the settings the simulation thread reads, the caller holds the
+// simulation mutex once that thread runs
+auto static
+share(
+	)
+	-> void
+{
+	tick_rate_    = std::max(tick_rate, 1e-4F);
+	max_substeps_ = std::max(max_substeps, 1U);
+	overrun_      = overrun;
+	tick_budget_  = tick_budget;
+	fixed_frame_  = fixed_frame;
+}
+
+// Smooth the tick cost, once a second Adaptive runs longer ticks when they
+// cost more than the budget and shorter ones when that would still fit
+auto static
+measure(
+	double                      const cost,
+	float                       const length,
+	profiler::clock::time_point const now
+	)
+	-> void
+{
+	steps_.tick_cost = steps_.tick_cost == 0.0 ? cost : steps_.tick_cost * 0.9 + cost * 0.1;
+
+	// Adapting to the wall clock would make fixed frame runs irreproducible
+	if (overrun_ != Overrun::Adaptive || fixed_frame_ > 0.0F)
+	{
+		steps_.interval = 1U;
+		return;
+	}
+
+	if (now - evaluated_ < std::chrono::seconds(1))
+		return;
+	evaluated_ = now;
+
+	auto const load = steps_.tick_cost / (double(length) * 1000.0);
+	if (load > double(tick_budget_) && steps_.interval < max_interval_)
+		steps_.interval *= 2U;
+	else if (load * 2.0 < double(tick_budget_) * 0.75 && steps_.interval > 1U)
+		steps_.interval /= 2U;
+}
+
+// Backlog (in simulated seconds) past the substep cap, keep only the part of
+// a tick that alpha needs
+auto static
+drop(
+	float&              backlog,
+	float         const length,
+	std::uint32_t const substeps
+	)
+	-> void
+{
+	auto const excess = backlog - std::fmod(backlog, length);
+	backlog        -= excess;
+	steps_.dropped += double(excess);
+	++steps_.capped;
+
+	if (overrun_ == Overrun::Dilate)
+		steps_.time_scale = std::max(
+			steps_.time_scale * float(substeps) / (float(substeps) + excess / length),
+			min_time_scale_);
+}
+
+// Ticks kept up over elapsed real seconds
+auto static
+recover(
+	float const elapsed
+	)
+	-> void
+{
+	steps_.time_scale = overrun_ == Overrun::Dilate
+		? std::min(steps_.time_scale + elapsed * recovery_, 1.0F)
+		: 1.0F;
+}
+
 
 
 // Setup
@@ -23,6 +231,7 @@ setup(
 	)
 	-> void
 {
+	jobs::start(workers);
 	renderer::start();
 	setup_function();
 }
@@ -45,6 +254,34 @@ input(
 
 
 
+// Camera movement, every frame so the view never lags behind a tick
+auto static
+move_camera(
+	float delta_time
+	)
+	-> void
+{
+	if (renderer::keyboard()[GLFW_KEY_W])
+		renderer::camera.move(Camera::Forward, delta_time);
+
+	if (renderer::keyboard()[GLFW_KEY_A])
+		renderer::camera.move(Camera::Left, delta_time);
+
+	if (renderer::keyboard()[GLFW_KEY_S])
+		renderer::camera.move(Camera::Backward, delta_time);
+
+	if (renderer::keyboard()[GLFW_KEY_D])
+		renderer::camera.move(Camera::Right, delta_time);
+
+	if (renderer::keyboard()[GLFW_KEY_SPACE])
+		renderer::camera.move(Camera::Up, delta_time);
+
+	if (renderer::keyboard()[GLFW_KEY_LEFT_SHIFT])
+		renderer::camera.move(Camera::Down, delta_time);
+}
+
+
+
 // Update
 auto static
 update(
@@ -52,6 +289,7 @@ update(
 	)
 	-> void
 {
+	move_camera(delta_time);
 	update_function(delta_time);
 }
 
@@ -64,25 +302,140 @@ fixed_update(
 	)
 	-> void
 {
-	if (renderer::keyboard()[GLFW_KEY_W])
-		renderer::camera.move(Camera::Forward, delta_time);
+	fixed_update_function(delta_time);
+}
 
-	if (renderer::keyboard()[GLFW_KEY_A])
-		renderer::camera.move(Camera::Left, delta_time);
 
-	if (renderer::keyboard()[GLFW_KEY_S])
-		renderer::camera.move(Camera::Backward, delta_time);
 
-	if (renderer::keyboard()[GLFW_KEY_D])
-		renderer::camera.move(Camera::Right, delta_time);
+// Frame pacing
+// Oversleep when asking for a millisecond, tracked as a running mean and
+// variance. Sleeping stops once the time left is within a deviation of it,
+// the rest is spun for an exact wake
+auto static sleep_mean_  = 0.002;
+auto static sleep_m2_    = 0.0;
+auto static sleep_count_ = std::uint64_t(0U);
 
-	if (renderer::keyboard()[GLFW_KEY_SPACE])
-		renderer::camera.move(Camera::Up, delta_time);
+auto static
+pace(
+	renderer::time_point const deadline
+	)
+	-> void
+{
+	for (;;)
+	{
+		auto const now       = renderer::clock::now();
+		auto const remaining = std::chrono::duration<double>(deadline - now).count();
+		auto const deviation = sleep_count_ > 1U ? std::sqrt(sleep_m2_ / double(sleep_count_ - 1U)) : 0.0;
+		if (remaining <= sleep_mean_ + deviation)
+			break;
 
-	if (renderer::keyboard()[GLFW_KEY_LEFT_SHIFT])
-		renderer::camera.move(Camera::Down, delta_time);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
-	fixed_update_function(delta_time);
+		// Welford update, restarted now and then so it follows the system
+		if (sleep_count_ == 1000U)
+		{
+			sleep_count_ = 1U;
+			sleep_m2_    = 0.0;
+		}
+
+		auto const slept = std::chrono::duration<double>(renderer::clock::now() - now).count();
+		auto const delta = slept - sleep_mean_;
+		++sleep_count_;
+		sleep_mean_ += delta / double(sleep_count_);
+		sleep_m2_   += delta * (slept - sleep_mean_);
+	}
+
+	while (renderer::clock::now() < deadline)
+	{}
+}
+
+
+
+// Simulation thread
+auto static
+simulate(
+	)
+	-> void
+{
+	auto const wall = [](float const seconds)
+	{
+		return std::chrono::duration_cast<profiler::clock::duration>(
+			std::chrono::duration<double>(seconds));
+	};
+
+	auto next  = profiler::clock::now();
+	auto ticks = std::uint64_t(0U);
+	auto time  = 0.0;
+	auto last  = Snapshot();
+	while (!stopping_.load(std::memory_order_relaxed))
+	{
+		auto length     = 0.0F;
+		auto time_scale = 1.0F;
+		{
+			auto const lock = std::lock_guard(simulation_mutex_);
+			length     = tick_rate_ * float(steps_.interval);
+			time_scale = steps_.time_scale;
+		}
+
+		auto const start = profiler::clock::now();
+		input::advance(start);
+		fixed_update(length);
+		++ticks;
+		time += double(length);
+
+		auto& published         = snapshots_.write();
+		published.previous      = last;
+		published.snapshot.tick = ticks;
+		published.snapshot.time = time;
+		publish_function(published.snapshot);
+		last               = published.snapshot;
+		published.time     = profiler::clock::now();
+		published.interval = wall(length / time_scale);
+		snapshots_.publish();
+
+		next += published.interval;
+		{
+			auto const lock = std::lock_guard(simulation_mutex_);
+			record(simulation_window_, start, published.time);
+			measure(std::chrono::duration<double, std::milli>(published.time - start).count(), length, published.time);
+
+			// More than the cap behind, drop the backlog instead of spiralling
+			auto const behind  = std::chrono::duration<float>(published.time - next).count();
+			auto       backlog = behind * time_scale;
+			steps_.policy   = overrun_;
+			steps_.substeps = std::uint32_t(std::max(backlog / length, 0.0F)) + 1U;
+			if (backlog > length * float(max_substeps_))
+			{
+				drop(backlog, length, max_substeps_);
+				next = published.time - wall(backlog / time_scale);
+			}
+			else
+				recover(length / time_scale);
+		}
+
+		std::this_thread::sleep_until(next);
+	}
+}
+
+
+
+// Take the newest snapshot from the simulation thread
+auto static
+receive(
+	)
+	-> void
+{
+	if (snapshots_.update())
+	{
+		auto const& published = snapshots_.read();
+		previous_  = published.previous;
+		current_   = published.snapshot;
+		published_ = published.time;
+		interval_  = published.interval;
+	}
+
+	auto const elapsed = std::chrono::duration<float>(profiler::clock::now() - published_);
+	alpha_ = std::clamp(elapsed / std::chrono::duration<float>(interval_), 0.0F, 1.0F);
 }
 
 
@@ -104,7 +457,15 @@ close(
 	)
 	-> void
 {
+	if (simulation_.joinable())
+	{
+		stopping_ = true;
+		simulation_.join();
+	}
+
 	close_function();
+	jobs::shutdown();
+	profiler::shutdown();
 	renderer::shutdown();
 }
 
@@ -118,33 +479,141 @@ run(
 {
 	setup();
 
-	auto           time         = 0.0F;
-	auto           accumulator  = 0.0F;
-	auto constexpr tick_rate    = 1.0F / 60.0F;
-	auto           current_time = renderer::clock::now();
+	auto accumulator  = 0.0F;
+	auto current_time = renderer::clock::now();
+	auto next_frame   = current_time;
+
+	share();
+	threading_ = threaded;
+	if (threading_ && fixed_frame > 0.0F)
+	{
+		std::cerr << "WARNING: Fixed frame runs only reproduce on one thread, simulating on the render thread" << std::endl;
+		threading_ = false;
+	}
+
+	if (threading_)
+	{
+		stopping_   = false;
+		simulation_ = std::thread(simulate);
+	}
 
 	while (renderer::is_running())
 	{
+		// Fixed frames step simulated time exactly, whatever the wall clock
 		auto       new_time   = renderer::clock::now();
-		auto const delta_time = renderer::duration(new_time - current_time).count();
+		auto const delta_time = fixed_frame > 0.0F ? fixed_frame : renderer::duration(new_time - current_time).count();
+		auto const start      = profiler::clock::now();
 		current_time          = new_time;
-		accumulator          += delta_time;
 
-		renderer::update(new_time);
+		{
+			auto const lock = std::lock_guard(simulation_mutex_);
+			share();
+		}
+
+		profiler::new_frame();
+		state::new_frame();
+		renderer::framebuffers.new_frame();
 
+		profiler::begin("input");
+		renderer::update(new_time);
+		if (!late_latch)
+			renderer::aim_camera();
 		input();
+		profiler::end();
 
+		profiler::begin("update");
 		update(delta_time);
+		profiler::end();
 
-		while (accumulator >= tick_rate)
+		if (threading_)
+		{
+			profiler::begin("simulation");
+			receive();
+			profiler::end();
+		}
+		else
 		{
-			accumulator -= tick_rate;
-			time        += tick_rate;
+			profiler::begin("fixed_update");
+			auto length     = tick_rate;
+			auto time_scale = 1.0F;
+			{
+				auto const lock = std::lock_guard(simulation_mutex_);
+				length       = tick_rate_ * float(steps_.interval);
+				time_scale   = steps_.time_scale;
+				accumulator += delta_time * time_scale;
+			}
+
+			auto substeps = 0U;
+			for (; accumulator >= length && substeps < std::max(max_substeps, 1U); accumulator -= length)
+			{
+				auto const tick = profiler::clock::now();
+				for (auto const mesh : tracked_)
+					mesh->save_transform();
+
+				// Each tick takes the events of the real time it stands for
+				auto const remaining = std::chrono::duration<double>((accumulator - length) / time_scale);
+				input::advance(new_time - std::chrono::duration_cast<renderer::clock::duration>(remaining));
+
+				fixed_update(length);
+				++substeps;
+
+				std::swap(previous_, current_);
+				current_.tick = previous_.tick + 1U;
+				current_.time = previous_.time + double(length);
+				publish_function(current_);
+
+				auto const now  = profiler::clock::now();
+				auto const lock = std::lock_guard(simulation_mutex_);
+				record(simulation_window_, tick, now);
+				measure(std::chrono::duration<double, std::milli>(now - tick).count(), length, now);
+			}
+
+			{
+				auto const lock = std::lock_guard(simulation_mutex_);
+				steps_.policy   = overrun_;
+				steps_.substeps = substeps;
+				if (accumulator >= length)
+					drop(accumulator, length, substeps);
+				else
+					recover(delta_time);
+			}
+
+			alpha_ = accumulator / length;
+			profiler::end();
+		}
 
-			fixed_update(tick_rate);
+		// Take mouse movement up to the last moment before drawing
+		if (late_latch)
+		{
+			profiler::begin("late latch");
+			renderer::poll();
+			renderer::aim_camera();
+			profiler::end();
 		}
 
+		profiler::begin("render");
 		render();
+		profiler::end();
+
+		record(render_window_, start, profiler::clock::now());
+
+		// Sleep most of the way to the next frame and spin the rest, a frame
+		// behind starts over rather than rushing to catch up
+		if (max_frame_rate > 0.0F)
+		{
+			auto const period = std::chrono::duration_cast<renderer::clock::duration>(
+				std::chrono::duration<double>(1.0 / double(max_frame_rate)));
+
+			next_frame += period;
+			if (next_frame + period < renderer::clock::now())
+				next_frame = renderer::clock::now();
+			else
+			{
+				profiler::begin("pace");
+				pace(next_frame);
+				profiler::end();
+			}
+		}
 	}
 
 	close();
@@ -152,4 +621,108 @@ run(
 
 
 
+// Snapshots
+auto
+snapshot(
+	)
+	-> Snapshot const&
+{
+	return current_;
+}
+
+auto
+previous_snapshot(
+	)
+	-> Snapshot const&
+{
+	return previous_;
+}
+
+auto
+alpha(
+	)
+	-> float
+{
+	return alpha_;
+}
+
+auto
+track(
+	Mesh& mesh
+	)
+	-> void
+{
+	if (std::find(tracked_.begin(), tracked_.end(), &mesh) != tracked_.end())
+		return;
+
+	mesh.save_transform();
+	tracked_.push_back(&mesh);
+}
+
+auto
+untrack(
+	Mesh const& mesh
+	)
+	-> void
+{
+	tracked_.erase(std::remove(tracked_.begin(), tracked_.end(), &mesh), tracked_.end());
+}
+
+
+
+// Statistics
+auto
+step_stats(
+	)
+	-> StepStats
+{
+	auto const lock = std::lock_guard(simulation_mutex_);
+	return steps_;
+}
+
+auto
+render_stats(
+	)
+	-> LoopStats
+{
+	return render_window_.last;
+}
+
+auto
+simulation_stats(
+	)
+	-> LoopStats
+{
+	auto const lock = std::lock_guard(simulation_mutex_);
+	return simulation_window_.last;
+}
+
+auto
+report(
+	)
+	-> void
+{
+	auto const print = [](char const* const name, LoopStats const& stats)
+	{
+		std::cout << name << "\t| " <<
+			stats.count << "Hz\t| average " <<
+			stats.average << "ms\t| max " <<
+			stats.maximum << "ms" << std::endl;
+	};
+
+	std::cout << (threading_ ? "Threaded loops" : "Loops") << std::endl;
+	print("- render", render_stats());
+	print("- simulation", simulation_stats());
+
+	auto const steps = step_stats();
+	auto const names = std::array{ "drop", "dilate", "adaptive" };
+	std::cout << "Catch-up " <<
+		names[std::size_t(steps.policy)] << ", capped " <<
+		steps.capped << " times, dropped " <<
+		steps.dropped << "s, time scale " <<
+		steps.time_scale << ", tick interval " <<
+		steps.interval << "x, tick cost " <<
+		steps.tick_cost << "ms" << std::endl;
+}
+
 } // namespace ogl::app
@@ -0,0 +1,407 @@
+#include <e3d/ogl/atlas.hh>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+
+#include <glm/glm.hpp>
+
+#include <e3d/ogl/state.hh>
+
+
+
+namespace ogl
+{
+
+// Constructors
+Skyline::
+Skyline(
+	std::uint32_t const width,
+	std::uint32_t const height
+	) :
+	width_(width),
+	height_(height),
+	nodes_{ Node{ 0U, 0U, width } }
+{}
+
+
+
+// Packing
+auto Skyline::
+insert(
+	std::uint32_t const width,
+	std::uint32_t const height
+	)
+	-> std::optional<glm::uvec2>
+{
+	// Lowest top edge wins, narrowest segment breaks ties
+	auto best       = nodes_.size();
+	auto best_y     = std::numeric_limits<std::uint32_t>::max();
+	auto best_width = std::numeric_limits<std::uint32_t>::max();
+
+	for (auto i = std::size_t(0U); i < nodes_.size(); ++i)
+	{
+		if (nodes_[i].x + width > width_)
+			break;
+
+		// The rectangle rests on the highest segment it spans
+		auto y         = nodes_[i].y;
+		auto remaining = width;
+		auto fits      = true;
+		for (auto j = i; remaining > 0U; ++j)
+		{
+			if (j == nodes_.size())
+			{
+				fits = false;
+				break;
+			}
+
+			y = std::max(y, nodes_[j].y);
+			if (y + height > height_)
+			{
+				fits = false;
+				break;
+			}
+
+			remaining -= std::min(remaining, nodes_[j].width);
+		}
+
+		if (fits && (y + height < best_y || (y + height == best_y && nodes_[i].width < best_width)))
+		{
+			best       = i;
+			best_y     = y + height;
+			best_width = nodes_[i].width;
+		}
+	}
+
+	if (best == nodes_.size())
+		return std::nullopt;
+
+	auto const position = glm::uvec2(nodes_[best].x, best_y - height);
+	nodes_.insert(nodes_.begin() + std::ptrdiff_t(best), Node{ position.x, best_y, width });
+
+	// Trim the segments now underneath the new one
+	for (auto i = best + 1U; i < nodes_.size(); )
+	{
+		auto const end = nodes_[i - 1U].x + nodes_[i - 1U].width;
+		if (nodes_[i].x >= end)
+			break;
+
+		auto const shrink = end - nodes_[i].x;
+		if (nodes_[i].width <= shrink)
+		{
+			nodes_.erase(nodes_.begin() + std::ptrdiff_t(i));
+			continue;
+		}
+
+		nodes_[i].x     += shrink;
+		nodes_[i].width -= shrink;
+		break;
+	}
+
+	// Merge neighbours of equal height
+	for (auto i = std::size_t(0U); i + 1U < nodes_.size(); )
+		if (nodes_[i].y == nodes_[i + 1U].y)
+		{
+			nodes_[i].width += nodes_[i + 1U].width;
+			nodes_.erase(nodes_.begin() + std::ptrdiff_t(i + 1U));
+		}
+		else
+			++i;
+
+	used_ += std::uint64_t(width) * height;
+	return position;
+}
+
+auto Skyline::
+occupancy(
+	) const
+	-> float
+{
+	return float(double(used_) / (double(width_) * height_));
+}
+
+
+
+// Copy an image into a padded block, extending its edges
+auto static
+pad(
+	Image const&  image,
+	std::uint32_t padding
+	)
+	-> Image
+{
+	auto result     = Image();
+	result.width    = image.width + padding * 2U;
+	result.height   = image.height + padding * 2U;
+	result.channels = 4U;
+	result.pixels.resize(std::size_t(result.width) * result.height * 4U);
+
+	for (auto y = 0U; y < result.height; ++y)
+	{
+		auto const sy = std::min(std::max(y, padding) - padding, image.height - 1U);
+		for (auto x = 0U; x < result.width; ++x)
+		{
+			auto const sx = std::min(std::max(x, padding) - padding, image.width - 1U);
+			std::memcpy(result.row(y) + x * 4U, image.row(sy) + sx * 4U, 4U);
+		}
+	}
+
+	return result;
+}
+
+
+
+// Constructors
+TextureAtlas::
+TextureAtlas(
+	GLuint const size,
+	GLuint const padding
+	) :
+	size_(size),
+	padding_(padding)
+{
+	texture_.type_   = GL_TEXTURE_2D_ARRAY;
+	texture_.width_  = size;
+	texture_.height_ = size;
+}
+
+
+
+// Building
+auto TextureAtlas::
+add(
+	std::string const& path
+	)
+	-> bool
+{
+	if (entries_.count(path))
+		return true;
+
+	auto image = read_image(path);
+	if (!image)
+		return false;
+
+	if (image->width + padding_ * 2U > size_ || image->height + padding_ * 2U > size_)
+	{
+		std::cerr << "ERROR: Texture " <<
+			path << " does not fit in a " <<
+			size_ << "x" << size_ << " atlas layer" << std::endl;
+		return false;
+	}
+
+	// Layers are stored bottom row first, like uvs
+	auto rgba = image->to_rgba();
+	rgba.flip_vertical();
+
+	entries_[path].image = std::move(rgba);
+	return true;
+}
+
+auto TextureAtlas::
+add_material(
+	obj::Material const& material,
+	std::string const&   directory
+	)
+	-> bool
+{
+	if (material.diffuse_texture_map.empty())
+		return false;
+
+	return add((std::filesystem::path(directory) / material.diffuse_texture_map).lexically_normal().string());
+}
+
+auto TextureAtlas::
+build(
+	)
+	-> bool
+{
+	// Tallest first keeps the skyline flat
+	auto order = std::vector<std::pair<std::string const*, Entry*>>();
+	for (auto& [path, entry] : entries_)
+		order.emplace_back(&path, &entry);
+	std::sort(order.begin(), order.end(),
+		[](auto const& a, auto const& b)
+		{
+			return a.second->image.height != b.second->image.height
+				? a.second->image.height > b.second->image.height
+				: a.second->image.width > b.second->image.width;
+		});
+
+	auto placed = std::vector<std::pair<Image, glm::uvec3>>();
+	layers_.clear();
+	for (auto const& [path, entry] : order)
+	{
+		auto padded = pad(entry->image, padding_);
+
+		auto position = std::optional<glm::uvec2>();
+		auto layer    = std::size_t(0U);
+		for (; layer < layers_.size() && !position; ++layer)
+			position = layers_[layer].insert(padded.width, padded.height);
+
+		if (!position)
+		{
+			layers_.emplace_back(size_, size_);
+			position = layers_.back().insert(padded.width, padded.height);
+			layer    = layers_.size();
+		}
+		--layer;
+
+		auto region   = Region();
+		region.layer  = std::uint32_t(layer);
+		region.offset = glm::vec2(*position + padding_) / float(size_);
+		region.scale  = glm::vec2(entry->image.width, entry->image.height) / float(size_);
+		entry->region = region;
+
+		placed.emplace_back(std::move(padded), glm::uvec3(*position, layer));
+	}
+
+	if (layers_.empty())
+		return false;
+
+	// Upload every layer, then mips no deeper than the padding protects
+	auto levels = 1;
+	for (auto p = padding_; p > 1U; p /= 2U)
+		++levels;
+
+	state::bind_texture_for_edit(0U, texture_.type_, texture_.id_);
+	glTexImage3D(
+		texture_.type_,
+		0,
+		GL_RGBA8,
+		GLsizei(size_),
+		GLsizei(size_),
+		GLsizei(layers_.size()),
+		0,
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		nullptr);
+
+	state::bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0U);
+	for (auto const& [image, at] : placed)
+		glTexSubImage3D(
+			texture_.type_,
+			0,
+			GLint(at.x),
+			GLint(at.y),
+			GLint(at.z),
+			GLsizei(image.width),
+			GLsizei(image.height),
+			1,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			image.pixels.data());
+
+	glTexParameteri(texture_.type_, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	glTexParameteri(texture_.type_, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(texture_.type_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(texture_.type_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(texture_.type_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glGenerateMipmap(texture_.type_);
+
+	texture_.levels_     = GLuint(levels);
+	texture_.size_bytes_ = 0U;
+	for (auto l = 0; l < levels; ++l)
+		texture_.size_bytes_ += std::size_t(size_ >> l) * (size_ >> l) * 4U * layers_.size();
+	texture_.ready_ = true;
+
+	std::cout << "Texture atlas packed " <<
+		entries_.size() << " textures into " <<
+		layers_.size() << " layers (";
+	for (auto i = std::size_t(0U); i < layers_.size(); ++i)
+		std::cout << (i ? ", " : "") << int(layers_[i].occupancy() * 100.0F) << "%";
+	std::cout << " used)" << std::endl;
+
+	return true;
+}
+
+
+
+// Regions
+auto TextureAtlas::Region::
+map(
+	glm::vec2 const uv
+	) const
+	-> glm::vec2
+{
+	return offset + glm::clamp(uv, glm::vec2(0.0F), glm::vec2(1.0F)) * scale;
+}
+
+auto TextureAtlas::
+region(
+	std::string const& path
+	) const
+	-> std::optional<Region>
+{
+	auto const it = entries_.find(path);
+	if (it == entries_.end())
+		return std::nullopt;
+
+	return it->second.region;
+}
+
+auto TextureAtlas::
+remap(
+	obj::Mesh&         mesh,
+	std::string const& directory
+	) const
+	-> std::optional<std::uint32_t>
+{
+	if (mesh.material.diffuse_texture_map.empty())
+		return std::nullopt;
+
+	auto const path   = (std::filesystem::path(directory) / mesh.material.diffuse_texture_map).lexically_normal().string();
+	auto const placed = region(path);
+	if (!placed)
+	{
+		std::cerr << "ERROR: Texture " <<
+			path << " is not packed in the atlas" << std::endl;
+		return std::nullopt;
+	}
+
+	// A region cannot repeat, so tiling uvs are clamped
+	auto clamped = false;
+	for (auto& v : mesh.vertices)
+	{
+		clamped |= glm::clamp(v.uv, glm::vec2(0.0F), glm::vec2(1.0F)) != v.uv;
+		v.uv = placed->map(v.uv);
+	}
+
+	if (clamped)
+		std::cerr << "WARNING: Mesh " <<
+			mesh.name << " repeats its texture, uvs were clamped to the atlas region" << std::endl;
+
+	return placed->layer;
+}
+
+
+
+// Details
+auto TextureAtlas::
+texture(
+	) const
+	-> Texture const&
+{
+	return texture_;
+}
+
+auto TextureAtlas::
+layers(
+	) const
+	-> std::size_t
+{
+	return layers_.size();
+}
+
+auto TextureAtlas::
+bind(
+	GLuint const unit
+	) const
+	-> void
+{
+	state::bind_texture(unit, texture_.type_, texture_.id_);
+}
+
+} // namespace ogl
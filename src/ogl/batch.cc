@@ -0,0 +1,462 @@
+#include <e3d/ogl/batch.hh>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+#include <e3d/ogl/jobs.hh>
+#include <e3d/ogl/profiler.hh>
+#include <e3d/ogl/state.hh>
+
+
+
+namespace ogl
+{
+
+// Vertices are welded by exact bit pattern
+struct VertexHash
+{
+	auto
+	operator()(
+		obj::Vertex const& v
+		) const
+		-> std::size_t
+	{
+		auto bytes = std::array<std::uint8_t, sizeof(obj::Vertex)>();
+		std::memcpy(bytes.data(), &v, sizeof(obj::Vertex));
+
+		// FNV-1a
+		auto hash = std::uint64_t(14695981039346656037ULL);
+		for (auto const b : bytes)
+			hash = (hash ^ b) * 1099511628211ULL;
+		return std::size_t(hash);
+	}
+};
+
+struct VertexEqual
+{
+	auto
+	operator()(
+		obj::Vertex const& a,
+		obj::Vertex const& b
+		) const
+		-> bool
+	{
+		return std::memcmp(&a, &b, sizeof(obj::Vertex)) == 0;
+	}
+};
+
+
+
+// Constructors
+StaticBatch::
+~StaticBatch(
+	)
+{
+	clear();
+}
+
+
+
+// Build
+auto StaticBatch::
+add(
+	Mesh const& mesh
+	)
+	-> void
+{
+	bake(mesh, nullptr);
+}
+
+auto StaticBatch::
+add(
+	Mesh                 const& mesh,
+	TextureAtlas::Region const& region
+	)
+	-> void
+{
+	bake(mesh, &region);
+}
+
+auto StaticBatch::
+bake(
+	Mesh                 const&       mesh,
+	TextureAtlas::Region const* const region
+	)
+	-> void
+{
+	if (mesh.vertices().empty())
+	{
+		std::cerr << "ERROR: Cannot batch an empty mesh" << std::endl;
+		return;
+	}
+
+	// Bake the atlas region so every draw shares the texture, the transform
+	// is baked by build
+	auto pending = Pending();
+	pending.shader    = mesh.shader;
+	pending.transform = mesh.current_transform();
+	pending.layer     = region ? region->layer : 0U;
+	pending.vertices.reserve(mesh.vertices().size());
+	for (auto v : mesh.vertices())
+	{
+		if (region)
+			v.uv = region->map(v.uv);
+		pending.vertices.push_back(v);
+	}
+
+	pending.bounds = mesh.bounds();
+	pending_.push_back(std::move(pending));
+}
+
+auto StaticBatch::
+build(
+	)
+	-> bool
+{
+	if (pending_.empty())
+	{
+		std::cerr << "ERROR: No meshes to batch" << std::endl;
+		return false;
+	}
+
+	// Replace any previous build
+	auto pending = std::move(pending_);
+	clear();
+
+	// Bake the transforms so every draw shares the identity model matrix,
+	// the matrices of all meshes are computed in one batch
+	auto transforms = TransformBatch();
+	transforms.resize(pending.size());
+	for (auto i = std::size_t(0U); i < pending.size(); ++i)
+		transforms.set(i, pending[i].transform);
+
+	auto models  = std::vector<glm::mat4>(pending.size());
+	auto normals = std::vector<glm::mat3>(pending.size());
+	compute_matrices(transforms, models.data(), normals.data());
+
+	for (auto i = std::size_t(0U); i < pending.size(); ++i)
+		for (auto& v : pending[i].vertices)
+		{
+			v.position = glm::vec3(models[i] * glm::vec4(v.position, 1.0F));
+			v.normal   = glm::normalize(normals[i] * v.normal);
+		}
+
+	// Meshes sharing a shader become one contiguous group
+	std::stable_sort(pending.begin(), pending.end(),
+		[](Pending const& a, Pending const& b) { return a.shader < b.shader; });
+
+	auto vertices = std::vector<obj::Vertex>();
+	auto layers   = std::vector<GLuint>();
+	auto indices  = std::vector<GLuint>();
+	auto welded   = std::unordered_map<obj::Vertex, GLuint, VertexHash, VertexEqual>();
+
+	for (auto const& p : pending)
+	{
+		if (groups_.empty() || groups_.back().shader != p.shader)
+		{
+			groups_.emplace_back();
+			groups_.back().shader = p.shader;
+			groups_.back().first  = commands_.size();
+		}
+
+		// Indices are absolute so the fallback path needs no base vertex
+		auto command        = DrawElementsIndirectCommand();
+		command.first_index = GLuint(indices.size());
+		command.count       = GLuint(p.vertices.size());
+
+		welded.clear();
+		for (auto const& v : p.vertices)
+		{
+			auto const [it, inserted] = welded.try_emplace(v, GLuint(vertices.size()));
+			if (inserted)
+			{
+				vertices.push_back(v);
+				layers.push_back(p.layer);
+			}
+			indices.push_back(it->second);
+		}
+
+		commands_.push_back(command);
+		bounds_.push_back(p.bounds);
+		++groups_.back().count;
+	}
+
+
+
+	// Interleaved vertices on the same locations as a mesh
+	glGenVertexArrays(1, &vao_);
+	state::bind_vertex_array(vao_);
+
+	glGenBuffers(1, &vbo_);
+	state::bind_buffer(GL_ARRAY_BUFFER, vbo_);
+	glBufferData(
+		GL_ARRAY_BUFFER,
+		GLsizeiptr(vertices.size() * sizeof(obj::Vertex)),
+		vertices.data(),
+		GL_STATIC_DRAW);
+
+	auto const stride = GLsizei(sizeof(obj::Vertex));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
+		reinterpret_cast<void const*>(offsetof(obj::Vertex, position)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+		reinterpret_cast<void const*>(offsetof(obj::Vertex, normal)));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+		reinterpret_cast<void const*>(offsetof(obj::Vertex, uv)));
+
+	// Atlas layers in their own stream, vertices are welded per mesh so
+	// none is shared between layers
+	glGenBuffers(1, &lbo_);
+	state::bind_buffer(GL_ARRAY_BUFFER, lbo_);
+	glBufferData(
+		GL_ARRAY_BUFFER,
+		GLsizeiptr(layers.size() * sizeof(GLuint)),
+		layers.data(),
+		GL_STATIC_DRAW);
+	glEnableVertexAttribArray(3);
+	glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, 0, nullptr);
+
+	glGenBuffers(1, &ebo_);
+	state::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+	glBufferData(
+		GL_ELEMENT_ARRAY_BUFFER,
+		GLsizeiptr(indices.size() * sizeof(GLuint)),
+		indices.data(),
+		GL_STATIC_DRAW);
+
+	state::bind_vertex_array(0);
+
+	// Visible commands are streamed in every frame
+	if (GLEW_ARB_multi_draw_indirect)
+	{
+		glGenBuffers(1, &ibo_);
+		state::bind_buffer(GL_DRAW_INDIRECT_BUFFER, ibo_);
+		glBufferData(
+			GL_DRAW_INDIRECT_BUFFER,
+			GLsizeiptr(commands_.size() * sizeof(DrawElementsIndirectCommand)),
+			nullptr,
+			GL_STREAM_DRAW);
+		state::bind_buffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+	inside_.resize(commands_.size(), 1U);
+	gathered_ = 0U;
+	visible_.reserve(commands_.size());
+	counts_.reserve(commands_.size());
+	offsets_.reserve(commands_.size());
+	return true;
+}
+
+auto StaticBatch::
+clear(
+	)
+	-> void
+{
+	state::release_vertex_array(vao_);
+	state::release_buffer(vbo_);
+	state::release_buffer(lbo_);
+	state::release_buffer(ibo_);
+
+	if (vao_)
+		glDeleteVertexArrays(1, &vao_);
+	if (vbo_)
+		glDeleteBuffers(1, &vbo_);
+	if (lbo_)
+		glDeleteBuffers(1, &lbo_);
+	if (ebo_)
+		glDeleteBuffers(1, &ebo_);
+	if (ibo_)
+		glDeleteBuffers(1, &ibo_);
+
+	vao_ = 0U;
+	vbo_ = 0U;
+	lbo_ = 0U;
+	ebo_ = 0U;
+	ibo_ = 0U;
+
+	pending_.clear();
+	commands_.clear();
+	bounds_.clear();
+	groups_.clear();
+	inside_.clear();
+	gathered_      = 0U;
+	draw_calls_    = 0U;
+	visible_count_ = 0U;
+}
+
+
+
+// Draw
+auto StaticBatch::
+gather(
+	Frustum         const* const frustum,
+	OcclusionBuffer*       const occlusion
+	)
+	-> void
+{
+	visible_count_ = 0U;
+
+	// Classify across the job workers, the gather below keeps draw order
+	if (frustum)
+		jobs::parallel_for(0U, bounds_.size(), 256U,
+			[this, frustum](std::size_t const begin, std::size_t const end)
+			{
+				for (auto i = begin; i < end; ++i)
+					inside_[i] = classify(*frustum, bounds_[i]) != Containment::Outside;
+			});
+	else
+		std::fill(inside_.begin(), inside_.end(), 1U);
+
+	// Then against the occluders, only what survived the frustum
+	if (occlusion)
+		occlusion->test(bounds_, inside_);
+
+	// Gather visible commands, joining neighbours into one range
+	visible_.clear();
+	for (auto& g : groups_)
+	{
+		g.visible_first = visible_.size();
+		for (auto i = g.first; i < g.first + g.count; ++i)
+		{
+			if (!inside_[i])
+				continue;
+
+			++visible_count_;
+			auto const& c = commands_[i];
+			if (visible_.size() > g.visible_first
+				&& visible_.back().first_index + visible_.back().count == c.first_index)
+				visible_.back().count += c.count;
+			else
+				visible_.push_back(c);
+		}
+		g.visible_count = visible_.size() - g.visible_first;
+	}
+}
+
+auto StaticBatch::
+draw(
+	bind_function   const& bind,
+	Frustum         const* const frustum,
+	std::uint64_t   const        version,
+	OcclusionBuffer*       const occlusion
+	)
+	-> void
+{
+	auto const scope = profiler::Scope("static batch");
+
+	draw_calls_ = 0U;
+	if (!vao_)
+		return;
+
+	// Nothing moved since the last gather, the visible commands (and the
+	// indirect buffer holding them) still hold
+	auto const stale = !frustum || version == 0U || version != gathered_ || occlusion;
+	if (stale)
+	{
+		gathered_ = frustum && !occlusion ? version : 0U;
+		gather(frustum, occlusion);
+	}
+
+	if (visible_.empty())
+		return;
+
+	state::bind_vertex_array(vao_);
+
+	// Bound every draw, other batches (and builds) bind their own in between
+	if (ibo_)
+		state::bind_buffer(GL_DRAW_INDIRECT_BUFFER, ibo_);
+
+	if (ibo_ && stale)
+	{
+		// Orphan last frame's commands rather than wait for them
+		glBufferData(
+			GL_DRAW_INDIRECT_BUFFER,
+			GLsizeiptr(commands_.size() * sizeof(DrawElementsIndirectCommand)),
+			nullptr,
+			GL_STREAM_DRAW);
+		glBufferSubData(
+			GL_DRAW_INDIRECT_BUFFER,
+			0,
+			GLsizeiptr(visible_.size() * sizeof(DrawElementsIndirectCommand)),
+			visible_.data());
+	}
+
+	for (auto const& g : groups_)
+	{
+		if (g.visible_count == 0U)
+			continue;
+
+		if (g.shader)
+		{
+			g.shader->use();
+			if (bind)
+				bind(*g.shader);
+		}
+
+		if (ibo_)
+		{
+			glMultiDrawElementsIndirect(
+				GL_TRIANGLES,
+				GL_UNSIGNED_INT,
+				reinterpret_cast<void const*>(g.visible_first * sizeof(DrawElementsIndirectCommand)),
+				GLsizei(g.visible_count),
+				0);
+		}
+		else
+		{
+			counts_.clear();
+			offsets_.clear();
+			for (auto i = g.visible_first; i < g.visible_first + g.visible_count; ++i)
+			{
+				counts_.push_back(GLsizei(visible_[i].count));
+				offsets_.push_back(reinterpret_cast<void const*>(
+					std::size_t(visible_[i].first_index) * sizeof(GLuint)));
+			}
+
+			glMultiDrawElements(
+				GL_TRIANGLES,
+				counts_.data(),
+				GL_UNSIGNED_INT,
+				offsets_.data(),
+				GLsizei(counts_.size()));
+		}
+
+		++draw_calls_;
+	}
+
+}
+
+
+
+// Statistics
+auto StaticBatch::
+size(
+	) const
+	-> std::size_t
+{
+	return commands_.size();
+}
+
+auto StaticBatch::
+draw_calls(
+	) const
+	-> std::size_t
+{
+	return draw_calls_;
+}
+
+auto StaticBatch::
+visible(
+	) const
+	-> std::size_t
+{
+	return visible_count_;
+}
+
+} // namespace ogl
@@ -0,0 +1,220 @@
+#include <e3d/ogl/bounds.hh>
+
+#include <algorithm>
+#include <cmath>
+
+
+
+namespace ogl
+{
+
+// Details
+auto Aabb::
+centre(
+	) const
+	-> glm::vec3
+{
+	return (minimum + maximum) * 0.5F;
+}
+
+auto Aabb::
+extent(
+	) const
+	-> glm::vec3
+{
+	return maximum - minimum;
+}
+
+auto Aabb::
+surface_area(
+	) const
+	-> float
+{
+	auto const e = extent();
+	return 2.0F * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+auto Aabb::
+is_valid(
+	) const
+	-> bool
+{
+	return minimum.x <= maximum.x
+		&& minimum.y <= maximum.y
+		&& minimum.z <= maximum.z;
+}
+
+
+
+// Tests
+auto Aabb::
+contains(
+	Aabb const& other
+	) const
+	-> bool
+{
+	return minimum.x <= other.minimum.x && other.maximum.x <= maximum.x
+		&& minimum.y <= other.minimum.y && other.maximum.y <= maximum.y
+		&& minimum.z <= other.minimum.z && other.maximum.z <= maximum.z;
+}
+
+auto Aabb::
+overlaps(
+	Aabb const& other
+	) const
+	-> bool
+{
+	return minimum.x <= other.maximum.x && other.minimum.x <= maximum.x
+		&& minimum.y <= other.maximum.y && other.minimum.y <= maximum.y
+		&& minimum.z <= other.maximum.z && other.minimum.z <= maximum.z;
+}
+
+
+
+// Growth
+auto Aabb::
+expand(
+	glm::vec3 const point
+	)
+	-> void
+{
+	minimum = glm::min(minimum, point);
+	maximum = glm::max(maximum, point);
+}
+
+auto Aabb::
+expand(
+	Aabb const& other
+	)
+	-> void
+{
+	minimum = glm::min(minimum, other.minimum);
+	maximum = glm::max(maximum, other.maximum);
+}
+
+
+
+// Combine two boxes
+auto
+merge(
+	Aabb const& a,
+	Aabb const& b
+	)
+	-> Aabb
+{
+	return Aabb{
+		glm::min(a.minimum, b.minimum),
+		glm::max(a.maximum, b.maximum) };
+}
+
+auto
+transform(
+	Aabb      const& box,
+	glm::mat4 const& matrix
+	)
+	-> Aabb
+{
+	// Arvo's method, project each axis of the box through the matrix
+	auto result = Aabb{
+		glm::vec3(matrix[3]),
+		glm::vec3(matrix[3]) };
+
+	for (auto i = 0; i < 3; ++i)
+	{
+		auto const axis = glm::vec3(matrix[i]);
+		auto const a    = axis * box.minimum[i];
+		auto const b    = axis * box.maximum[i];
+		result.minimum += glm::min(a, b);
+		result.maximum += glm::max(a, b);
+	}
+
+	return result;
+}
+
+auto
+frustum(
+	glm::mat4 const& view_projection,
+	bool      const  zero_to_one
+	)
+	-> Frustum
+{
+	auto const& m   = view_projection;
+	auto const  row = [&m](int const i)
+	{
+		return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+	};
+
+	auto result = Frustum();
+	result.planes[0] = row(3) + row(0);
+	result.planes[1] = row(3) - row(0);
+	result.planes[2] = row(3) + row(1);
+	result.planes[3] = row(3) - row(1);
+	result.planes[4] = zero_to_one ? row(2) : row(3) + row(2);
+	result.planes[5] = row(3) - row(2);
+
+	// Normalise so plane distances are in world units, an infinite far plane
+	// comes out as (0, 0, 0, w > 0) and stays always inside
+	for (auto& p : result.planes)
+	{
+		auto const length = glm::length(glm::vec3(p));
+		if (length > 0.0F)
+			p /= length;
+	}
+
+	return result;
+}
+
+
+
+// Intersection
+auto
+intersect(
+	Ray   const& ray,
+	Aabb  const& box,
+	float const  max_distance
+	)
+	-> float
+{
+	// Slab test, division by zero gives infinities which compare correctly
+	auto const inverse = 1.0F / ray.direction;
+	auto const t0      = (box.minimum - ray.origin) * inverse;
+	auto const t1      = (box.maximum - ray.origin) * inverse;
+	auto const t_min   = glm::min(t0, t1);
+	auto const t_max   = glm::max(t0, t1);
+
+	auto const enter = std::max({ t_min.x, t_min.y, t_min.z, 0.0F });
+	auto const exit  = std::min({ t_max.x, t_max.y, t_max.z, max_distance });
+
+	return enter <= exit
+		? enter
+		: -1.0F;
+}
+
+auto
+classify(
+	Frustum const& frustum,
+	Aabb    const& box
+	)
+	-> Containment
+{
+	auto const centre = box.centre();
+	auto const half   = box.extent() * 0.5F;
+	auto       result = Containment::Inside;
+
+	for (auto const& p : frustum.planes)
+	{
+		// Signed distance of centre against projected radius
+		auto const normal   = glm::vec3(p);
+		auto const distance = glm::dot(normal, centre) + p.w;
+		auto const radius   = glm::dot(glm::abs(normal), half);
+
+		if (distance < -radius)
+			return Containment::Outside;
+		if (distance < radius)
+			result = Containment::Intersects;
+	}
+
+	return result;
+}
+
+} // namespace ogl
@@ -0,0 +1,720 @@
+#include <e3d/ogl/bvh.hh>
+
+#include <algorithm>
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+
+
+namespace ogl
+{
+
+// Traversal stack shared by queries on the same thread
+std::vector<Bvh::Proxy> thread_local static stack_;
+
+// Marks a frustum query node as entirely inside
+auto constexpr static inside_bit = Bvh::Proxy(1U) << 31U;
+
+
+
+// Queries
+auto Bvh::
+size(
+	) const
+	-> std::size_t
+{
+	return leaves_;
+}
+
+auto Bvh::
+height(
+	) const
+	-> std::size_t
+{
+	if (root_ == null)
+		return 0U;
+
+	// Depth first walk keeping the depth alongside each node
+	auto result = std::size_t(0U);
+	auto nodes  = std::vector<std::pair<Proxy, std::size_t>>{ { root_, 1U } };
+	while (!nodes.empty())
+	{
+		auto const [index, depth] = nodes.back();
+		nodes.pop_back();
+
+		result = std::max(result, depth);
+		if (!nodes_[index].is_leaf())
+		{
+			nodes.emplace_back(nodes_[index].left,  depth + 1U);
+			nodes.emplace_back(nodes_[index].right, depth + 1U);
+		}
+	}
+
+	return result;
+}
+
+auto Bvh::
+cost(
+	) const
+	-> float
+{
+	if (root_ == null)
+		return 0.0F;
+
+	// Surface area of internal nodes relative to the root
+	auto total = 0.0F;
+	for (auto const& n : nodes_)
+		if (n.used && !n.is_leaf())
+			total += n.bounds.surface_area();
+
+	auto const root_area = nodes_[root_].bounds.surface_area();
+	return root_area > 0.0F
+		? total / root_area
+		: 0.0F;
+}
+
+auto Bvh::
+object(
+	Proxy const proxy
+	) const
+	-> std::uint32_t
+{
+	return nodes_[proxy].object;
+}
+
+auto Bvh::
+bounds(
+	Proxy const proxy
+	) const
+	-> Aabb const&
+{
+	return nodes_[proxy].bounds;
+}
+
+
+
+// Management
+auto Bvh::
+insert(
+	Aabb          const& bounds,
+	std::uint32_t const  object
+	)
+	-> Proxy
+{
+	auto const leaf = allocate();
+	nodes_[leaf].bounds = bounds;
+	nodes_[leaf].object = object;
+	++leaves_;
+
+	insert_leaf(leaf);
+	return leaf;
+}
+
+auto Bvh::
+remove(
+	Proxy const proxy
+	)
+	-> void
+{
+	if (proxy >= nodes_.size() || !nodes_[proxy].used || !nodes_[proxy].is_leaf())
+	{
+		std::cerr << "ERROR: Cannot remove invalid BVH proxy " <<
+			proxy << std::endl;
+		return;
+	}
+
+	remove_leaf(proxy);
+	release(proxy);
+	--leaves_;
+}
+
+auto Bvh::
+move(
+	Proxy const  proxy,
+	Aabb  const& bounds
+	)
+	-> void
+{
+	nodes_[proxy].bounds = bounds;
+}
+
+auto Bvh::
+build(
+	)
+	-> void
+{
+	// Keep leaves (and so proxies), discard all internal nodes
+	auto leaves = std::vector<Proxy>();
+	leaves.reserve(leaves_);
+	for (auto i = Proxy(0U); i < nodes_.size(); ++i)
+	{
+		if (!nodes_[i].used)
+			continue;
+
+		if (nodes_[i].is_leaf())
+			leaves.push_back(i);
+		else
+			release(i);
+	}
+
+	root_ = null;
+	if (leaves.empty())
+		return;
+
+	// Centroids are binned rather than bounds
+	auto centroids = std::vector<glm::vec3>(nodes_.size());
+	for (auto const l : leaves)
+		centroids[l] = nodes_[l].bounds.centre();
+
+	struct Task
+	{
+		std::size_t begin;
+		std::size_t end;
+		Proxy       parent;
+		bool        left;
+	};
+
+	struct Bin
+	{
+		Aabb        bounds;
+		std::size_t count = 0U;
+	};
+
+	auto const bin_count = std::max(bins, 2U);
+	auto       bin_list  = std::vector<Bin>(bin_count);
+	auto       right_sa  = std::vector<float>(bin_count);
+	auto       tasks     = std::vector<Task>{ { 0U, leaves.size(), null, false } };
+
+	// Attach a node to the parent given by a task
+	auto const attach = [this](Task const& task, Proxy const node)
+	{
+		nodes_[node].parent = task.parent;
+		if (task.parent == null)
+			root_ = node;
+		else if (task.left)
+			nodes_[task.parent].left = node;
+		else
+			nodes_[task.parent].right = node;
+	};
+
+	while (!tasks.empty())
+	{
+		auto const task = tasks.back();
+		tasks.pop_back();
+
+		auto const begin = leaves.begin() + std::ptrdiff_t(task.begin);
+		auto const end   = leaves.begin() + std::ptrdiff_t(task.end);
+
+		// Single object ranges are the leaves themselves
+		if (task.end - task.begin == 1U)
+		{
+			attach(task, *begin);
+			continue;
+		}
+
+		// Bounds of the range and of its centroids
+		auto range_bounds    = Aabb();
+		auto centroid_bounds = Aabb();
+		for (auto it = begin; it != end; ++it)
+		{
+			range_bounds.expand(nodes_[*it].bounds);
+			centroid_bounds.expand(centroids[*it]);
+		}
+
+		auto const extent = centroid_bounds.extent();
+
+		// Find the cheapest bin split over all axes
+		auto best_cost  = std::numeric_limits<float>::max();
+		auto best_axis  = -1;
+		auto best_split = 0U;
+
+		for (auto axis = 0; axis < 3; ++axis)
+		{
+			if (extent[axis] <= 0.0F)
+				continue;
+
+			auto const scale = float(bin_count) / extent[axis];
+			auto const bin_of = [&](Proxy const l)
+			{
+				auto const b = std::uint32_t((centroids[l][axis] - centroid_bounds.minimum[axis]) * scale);
+				return std::min(b, bin_count - 1U);
+			};
+
+			std::fill(bin_list.begin(), bin_list.end(), Bin());
+			for (auto it = begin; it != end; ++it)
+			{
+				auto& bin = bin_list[bin_of(*it)];
+				bin.bounds.expand(nodes_[*it].bounds);
+				++bin.count;
+			}
+
+			// Sweep from the right to get areas of every right partition
+			auto accumulated = Aabb();
+			for (auto b = bin_count - 1U; b > 0U; --b)
+			{
+				accumulated.expand(bin_list[b].bounds);
+				right_sa[b] = accumulated.is_valid()
+					? accumulated.surface_area()
+					: 0.0F;
+			}
+
+			// Sweep from the left evaluating each split
+			accumulated      = Aabb();
+			auto left_count  = std::size_t(0U);
+			auto right_count = task.end - task.begin;
+			for (auto b = 0U; b < bin_count - 1U; ++b)
+			{
+				accumulated.expand(bin_list[b].bounds);
+				left_count  += bin_list[b].count;
+				right_count -= bin_list[b].count;
+
+				if (left_count == 0U || right_count == 0U)
+					continue;
+
+				auto const split_cost =
+					float(left_count) * accumulated.surface_area()
+					+ float(right_count) * right_sa[b + 1U];
+
+				if (split_cost < best_cost)
+				{
+					best_cost  = split_cost;
+					best_axis  = axis;
+					best_split = b;
+				}
+			}
+		}
+
+		// Partition on the best split, or in half when centroids coincide
+		auto middle = begin + (end - begin) / 2;
+		if (best_axis >= 0)
+		{
+			auto const scale = float(bin_count) / extent[best_axis];
+			middle = std::partition(begin, end, [&](Proxy const l)
+			{
+				auto const b = std::uint32_t((centroids[l][best_axis] - centroid_bounds.minimum[best_axis]) * scale);
+				return std::min(b, bin_count - 1U) <= best_split;
+			});
+		}
+
+		// Create internal node and split the range between its children
+		auto const node = allocate();
+		nodes_[node].bounds = range_bounds;
+		attach(task, node);
+
+		auto const split = task.begin + std::size_t(middle - begin);
+		tasks.push_back({ task.begin, split,    node, true  });
+		tasks.push_back({ split,      task.end, node, false });
+	}
+}
+
+auto Bvh::
+refit(
+	)
+	-> void
+{
+	if (root_ == null)
+		return;
+
+	// Pre-order list, visited in reverse so children come before parents
+	auto& order = stack_;
+	order.clear();
+	order.push_back(root_);
+	for (auto i = std::size_t(0U); i < order.size(); ++i)
+	{
+		auto const& n = nodes_[order[i]];
+		if (!n.is_leaf())
+		{
+			order.push_back(n.left);
+			order.push_back(n.right);
+		}
+	}
+
+	for (auto it = order.rbegin(); it != order.rend(); ++it)
+	{
+		auto& n = nodes_[*it];
+		if (n.is_leaf())
+			continue;
+
+		n.bounds = merge(nodes_[n.left].bounds, nodes_[n.right].bounds);
+		rotate(*it);
+	}
+}
+
+auto Bvh::
+clear(
+	)
+	-> void
+{
+	nodes_.clear();
+	free_.clear();
+	root_   = null;
+	leaves_ = 0U;
+}
+
+
+
+// Spatial queries
+auto Bvh::
+query(
+	Aabb                 const& bounds,
+	std::vector<std::uint32_t>& results
+	) const
+	-> void
+{
+	if (root_ == null)
+		return;
+
+	auto& stack = stack_;
+	stack.clear();
+	stack.push_back(root_);
+
+	while (!stack.empty())
+	{
+		auto const& n = nodes_[stack.back()];
+		stack.pop_back();
+
+		if (!n.bounds.overlaps(bounds))
+			continue;
+
+		if (n.is_leaf())
+			results.push_back(n.object);
+		else
+		{
+			stack.push_back(n.left);
+			stack.push_back(n.right);
+		}
+	}
+}
+
+auto Bvh::
+query(
+	Frustum              const& frustum,
+	std::vector<std::uint32_t>& results
+	) const
+	-> void
+{
+	if (root_ == null)
+		return;
+
+	auto& stack = stack_;
+	stack.clear();
+	stack.push_back(root_);
+
+	while (!stack.empty())
+	{
+		auto const entry  = stack.back();
+		auto const inside = (entry & inside_bit) != 0U;
+		auto const& n     = nodes_[entry & ~inside_bit];
+		stack.pop_back();
+
+		// Subtrees entirely inside need no further plane tests
+		auto flag = inside_bit;
+		if (!inside)
+		{
+			auto const c = classify(frustum, n.bounds);
+			if (c == Containment::Outside)
+				continue;
+			if (c == Containment::Intersects)
+				flag = 0U;
+		}
+
+		if (n.is_leaf())
+			results.push_back(n.object);
+		else
+		{
+			stack.push_back(n.left  | flag);
+			stack.push_back(n.right | flag);
+		}
+	}
+}
+
+auto Bvh::
+raycast(
+	Ray      const& ray,
+	float    const  max_distance,
+	ray_test const& test
+	) const
+	-> std::optional<Hit>
+{
+	if (root_ == null)
+		return std::nullopt;
+
+	auto       closest = max_distance;
+	auto       result  = std::optional<Hit>();
+
+	auto& stack = stack_;
+	stack.clear();
+	if (intersect(ray, nodes_[root_].bounds, closest) >= 0.0F)
+		stack.push_back(root_);
+
+	while (!stack.empty())
+	{
+		auto const& n = nodes_[stack.back()];
+		stack.pop_back();
+
+		// Nodes may have been pushed before a closer hit was found
+		if (intersect(ray, n.bounds, closest) < 0.0F)
+			continue;
+
+		if (n.is_leaf())
+		{
+			auto const distance = test
+				? test(n.object, ray)
+				: std::optional<float>(intersect(ray, n.bounds, closest));
+
+			if (distance.has_value() && *distance >= 0.0F && *distance < closest)
+			{
+				closest = *distance;
+				result  = Hit{ n.object, *distance };
+			}
+			continue;
+		}
+
+		// Visit the nearer child first by pushing it last
+		auto const t_left  = intersect(ray, nodes_[n.left].bounds,  closest);
+		auto const t_right = intersect(ray, nodes_[n.right].bounds, closest);
+
+		if (t_left >= 0.0F && t_right >= 0.0F)
+		{
+			auto const left_first = t_left <= t_right;
+			stack.push_back(left_first ? n.right : n.left);
+			stack.push_back(left_first ? n.left  : n.right);
+		}
+		else if (t_left >= 0.0F)
+			stack.push_back(n.left);
+		else if (t_right >= 0.0F)
+			stack.push_back(n.right);
+	}
+
+	return result;
+}
+
+
+
+// Nodes
+auto Bvh::
+allocate(
+	)
+	-> Proxy
+{
+	auto index = null;
+	if (!free_.empty())
+	{
+		index = free_.back();
+		free_.pop_back();
+		nodes_[index] = Node();
+	}
+	else
+	{
+		index = Proxy(nodes_.size());
+		nodes_.emplace_back();
+	}
+
+	nodes_[index].used = true;
+	return index;
+}
+
+auto Bvh::
+release(
+	Proxy const proxy
+	)
+	-> void
+{
+	nodes_[proxy] = Node();
+	free_.push_back(proxy);
+}
+
+auto Bvh::
+insert_leaf(
+	Proxy const leaf
+	)
+	-> void
+{
+	if (root_ == null)
+	{
+		root_ = leaf;
+		nodes_[leaf].parent = null;
+		return;
+	}
+
+	// Descend towards the sibling with the lowest surface area cost
+	auto const box   = nodes_[leaf].bounds;
+	auto       index = root_;
+	while (!nodes_[index].is_leaf())
+	{
+		auto const& n        = nodes_[index];
+		auto const  area     = n.bounds.surface_area();
+		auto const  combined = merge(n.bounds, box).surface_area();
+
+		// Cost of pairing with this node, and cost pushed down to children
+		auto const cost        = 2.0F * combined;
+		auto const inheritance = 2.0F * (combined - area);
+
+		auto const child_cost = [&](Proxy const c)
+		{
+			auto const& child = nodes_[c];
+			auto const  grown = merge(child.bounds, box).surface_area();
+			return child.is_leaf()
+				? grown + inheritance
+				: grown - child.bounds.surface_area() + inheritance;
+		};
+
+		auto const cost_left  = child_cost(n.left);
+		auto const cost_right = child_cost(n.right);
+
+		if (cost < cost_left && cost < cost_right)
+			break;
+
+		index = cost_left < cost_right
+			? n.left
+			: n.right;
+	}
+
+	// Create a parent for the leaf and its new sibling
+	auto const sibling    = index;
+	auto const old_parent = nodes_[sibling].parent;
+	auto const new_parent = allocate();
+
+	nodes_[new_parent].parent = old_parent;
+	nodes_[new_parent].bounds = merge(box, nodes_[sibling].bounds);
+	nodes_[new_parent].left   = sibling;
+	nodes_[new_parent].right  = leaf;
+	nodes_[sibling].parent    = new_parent;
+	nodes_[leaf].parent       = new_parent;
+
+	if (old_parent == null)
+		root_ = new_parent;
+	else if (nodes_[old_parent].left == sibling)
+		nodes_[old_parent].left = new_parent;
+	else
+		nodes_[old_parent].right = new_parent;
+
+	// Refit ancestors
+	for (auto i = old_parent; i != null; i = nodes_[i].parent)
+	{
+		nodes_[i].bounds = merge(
+			nodes_[nodes_[i].left].bounds,
+			nodes_[nodes_[i].right].bounds);
+		rotate(i);
+	}
+}
+
+auto Bvh::
+remove_leaf(
+	Proxy const leaf
+	)
+	-> void
+{
+	if (leaf == root_)
+	{
+		root_ = null;
+		return;
+	}
+
+	auto const parent      = nodes_[leaf].parent;
+	auto const grandparent = nodes_[parent].parent;
+	auto const sibling     = nodes_[parent].left == leaf
+		? nodes_[parent].right
+		: nodes_[parent].left;
+
+	// Sibling takes the place of the parent
+	nodes_[sibling].parent = grandparent;
+	if (grandparent == null)
+		root_ = sibling;
+	else if (nodes_[grandparent].left == parent)
+		nodes_[grandparent].left = sibling;
+	else
+		nodes_[grandparent].right = sibling;
+
+	release(parent);
+
+	// Refit ancestors
+	for (auto i = grandparent; i != null; i = nodes_[i].parent)
+		nodes_[i].bounds = merge(
+			nodes_[nodes_[i].left].bounds,
+			nodes_[nodes_[i].right].bounds);
+}
+
+auto Bvh::
+rotate(
+	Proxy const node
+	)
+	-> void
+{
+	// Swap a child with a grandchild on the other side when that
+	// shrinks the intermediate node (Kopta et al. 2012)
+	auto const& n = nodes_[node];
+	if (n.is_leaf())
+		return;
+
+	auto best_gain       = 0.0F;
+	auto best_child      = null;
+	auto best_grandchild = null;
+
+	auto const consider = [&](Proxy const child, Proxy const other)
+	{
+		auto const& o = nodes_[other];
+		if (o.is_leaf())
+			return;
+
+		auto const area = o.bounds.surface_area();
+		auto const& c   = nodes_[child].bounds;
+
+		// Child swaps with o.left, o becomes { child, o.right }
+		auto const gain_left = area - merge(c, nodes_[o.right].bounds).surface_area();
+		if (gain_left > best_gain)
+		{
+			best_gain       = gain_left;
+			best_child      = child;
+			best_grandchild = o.left;
+		}
+
+		// Child swaps with o.right, o becomes { o.left, child }
+		auto const gain_right = area - merge(c, nodes_[o.left].bounds).surface_area();
+		if (gain_right > best_gain)
+		{
+			best_gain       = gain_right;
+			best_child      = child;
+			best_grandchild = o.right;
+		}
+	};
+
+	consider(n.left,  n.right);
+	consider(n.right, n.left);
+
+	if (best_child != null)
+		swap(best_child, best_grandchild);
+}
+
+auto Bvh::
+swap(
+	Proxy const child,
+	Proxy const grandchild
+	)
+	-> void
+{
+	auto const node  = nodes_[child].parent;
+	auto const other = nodes_[grandchild].parent;
+
+	// Exchange positions in both parents
+	if (nodes_[node].left == child)
+		nodes_[node].left = grandchild;
+	else
+		nodes_[node].right = grandchild;
+
+	if (nodes_[other].left == grandchild)
+		nodes_[other].left = child;
+	else
+		nodes_[other].right = child;
+
+	nodes_[child].parent      = other;
+	nodes_[grandchild].parent = node;
+
+	// Only the intermediate node changes shape
+	nodes_[other].bounds = merge(
+		nodes_[nodes_[other].left].bounds,
+		nodes_[nodes_[other].right].bounds);
+}
+
+} // namespace ogl
@@ -1,5 +1,7 @@
 #include "e3d/ogl/camera.hh"
 
+#include <atomic>
+#include <cmath>
 #include <limits>
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -14,6 +16,10 @@ glm::vec3 const Camera::world_right_ = glm::vec3(1.0F, 0.0F, 0.0F);
 glm::vec3 const Camera::world_front_ = glm::vec3(0.0F, 1.0F, 0.0F);
 glm::vec3 const Camera::world_up_    = glm::vec3(0.0F, 0.0F, 1.0F);
 
+// Versions are drawn from one counter, so no two cameras (or states of one)
+// ever share a version and caches keyed on it cannot mix them up
+auto static versions_ = std::atomic<std::uint64_t>(0U);
+
 
 
 // Constructor
@@ -42,17 +48,77 @@ aspect(
 auto Camera::
 projection(
 	) const
-	-> glm::mat4
+	-> glm::mat4 const&
 {
-	return glm::perspective(glm::radians(fov), aspect_, near, far);
+	refresh();
+	return projection_;
 }
 
 auto Camera::
 view(
 	) const
-	-> glm::mat4
+	-> glm::mat4 const&
+{
+	refresh();
+	return view_;
+}
+
+auto Camera::
+view_projection(
+	) const
+	-> glm::mat4 const&
+{
+	refresh();
+	return view_projection_;
+}
+
+auto Camera::
+version(
+	) const
+	-> std::uint64_t
+{
+	refresh();
+	return version_;
+}
+
+
+
+// Culling and picking
+auto Camera::
+frustum(
+	) const
+	-> Frustum const&
 {
-	return glm::lookAt(position, position + front_, up_);
+	refresh();
+	return frustum_;
+}
+
+auto Camera::
+ray(
+	glm::vec2 const screen_position,
+	glm::vec2 const resolution
+	) const
+	-> Ray
+{
+	// Screen position to normalised device coordinates (y is flipped)
+	auto const ndc = glm::vec2(
+		2.0F * screen_position.x / resolution.x - 1.0F,
+		1.0F - 2.0F * screen_position.y / resolution.y);
+
+	// Unproject points on the near plane and further along, reversed depth
+	// has its far plane at infinity so take one halfway there instead
+	auto const near_depth = reverse_z ? 1.0F : clip_zero_to_one ? 0.0F : -1.0F;
+	auto const far_depth  = reverse_z ? 0.5F : 1.0F;
+
+	auto const inverse = glm::inverse(view_projection());
+	auto       near_point = inverse * glm::vec4(ndc, near_depth, 1.0F);
+	auto       far_point  = inverse * glm::vec4(ndc, far_depth, 1.0F);
+	near_point /= near_point.w;
+	far_point  /= far_point.w;
+
+	return Ray{
+		position,
+		glm::normalize(glm::vec3(far_point - near_point)) };
 }
 
 
@@ -167,6 +233,72 @@ zoom_reset(
 
 
 // Update
+auto Camera::Inputs::
+operator==(
+	Inputs const& other
+	) const
+	-> bool
+{
+	return position == other.position
+		&& front == other.front
+		&& up == other.up
+		&& fov == other.fov
+		&& near == other.near
+		&& far == other.far
+		&& aspect == other.aspect
+		&& reverse_z == other.reverse_z
+		&& clip_zero_to_one == other.clip_zero_to_one;
+}
+
+auto Camera::
+refresh(
+	) const
+	-> void
+{
+	auto const inputs = Inputs{
+		position,
+		front_,
+		up_,
+		fov,
+		near,
+		far,
+		aspect_,
+		reverse_z,
+		clip_zero_to_one };
+
+	if (cached_ && inputs == inputs_)
+		return;
+
+	inputs_  = inputs;
+	cached_  = true;
+	version_ = versions_.fetch_add(1U, std::memory_order_relaxed) + 1U;
+
+	view_ = glm::lookAt(position, position + front_, up_);
+
+	if (!reverse_z)
+		projection_ = clip_zero_to_one
+			? glm::perspectiveRH_ZO(glm::radians(fov), aspect_, near, far)
+			: glm::perspective(glm::radians(fov), aspect_, near, far);
+	else
+	{
+		// Near maps to one and infinity to zero, floating point depth keeps
+		// its precision where the hyperbola needs it. Without a zero to one
+		// clip range half of the depth range is wasted on the other side of
+		// the far plane
+		auto const f = 1.0F / std::tan(glm::radians(fov) * 0.5F);
+
+		projection_       = glm::mat4(0.0F);
+		projection_[0][0] = f / aspect_;
+		projection_[1][1] = f;
+		projection_[2][3] = -1.0F;
+		projection_[2][2] = clip_zero_to_one ? 0.0F : 1.0F;
+		projection_[3][2] = clip_zero_to_one ? near : 2.0F * near;
+	}
+
+	view_projection_ = projection_ * view_;
+	frustum_         = ogl::frustum(view_projection_, clip_zero_to_one);
+}
+
 auto Camera::
 update_vectors(
 	)
@@ -0,0 +1,327 @@
+#include <e3d/ogl/capture.hh>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <e3d/ogl/profiler.hh>
+#include <e3d/ogl/renderer.hh>
+#include <e3d/ogl/state.hh>
+
+
+
+namespace ogl
+{
+
+// Copy bottom-up GL rows into a top-down image
+auto static
+copy_flipped(
+	std::uint8_t const* source,
+	Image&              image
+	)
+	-> void
+{
+	auto const stride = std::size_t(image.width) * image.channels;
+	for (auto y = 0U; y < image.height; ++y)
+		std::memcpy(
+			image.row(image.height - 1U - y),
+			source + stride * y,
+			stride);
+}
+
+
+
+// Constructors
+Capture::
+Capture(
+	encoder           encode,
+	std::size_t const buffers
+	) :
+	encode_(std::move(encode)),
+	slots_(std::make_unique<Slot[]>(std::max<std::size_t>(buffers, 2U))),
+	count_(std::max<std::size_t>(buffers, 2U)),
+	persistent_(GLEW_ARB_buffer_storage)
+{
+	for (auto i = std::size_t(0U); i < count_; ++i)
+		glGenBuffers(1, &slots_[i].buffer);
+
+	thread_ = std::thread(&Capture::run, this);
+}
+
+Capture::
+~Capture(
+	)
+{
+	flush();
+
+	{
+		auto const lock = std::lock_guard(mutex_);
+		stopping_ = true;
+	}
+	condition_.notify_all();
+	thread_.join();
+
+	for (auto i = std::size_t(0U); i < count_; ++i)
+	{
+		auto& slot = slots_[i];
+		if (slot.fence)
+			glDeleteSync(slot.fence);
+		state::release_buffer(slot.buffer);
+		glDeleteBuffers(1, &slot.buffer);
+	}
+}
+
+
+
+// Readback
+auto Capture::
+read(
+	Framebuffer const* const framebuffer
+	)
+	-> void
+{
+	auto const start = profiler::clock::now();
+	profiler::begin("capture");
+
+	auto const source = framebuffer
+		? framebuffer
+		: renderer::offscreen();
+
+	auto const resolution = renderer::resolution();
+	auto const width  = source ? source->width()  : std::uint32_t(resolution.x);
+	auto const height = source ? source->height() : std::uint32_t(resolution.y);
+	auto const size   = std::size_t(width) * height * 4U;
+	auto&      slot   = slots_[next_];
+	++frame_;
+
+	// Drop the frame rather than stall when the ring is full
+	if (slot.state.load() != Free)
+	{
+		poll();
+		if (slot.state.load() != Free)
+		{
+			++dropped_;
+			profiler::end();
+			time_ += std::chrono::duration<double, std::milli>(profiler::clock::now() - start).count();
+			return;
+		}
+	}
+
+	allocate(slot, size);
+	slot.width  = width;
+	slot.height = height;
+	slot.frame  = frame_;
+
+	// Transfer into the pixel buffer, returns without waiting
+	if (source)
+		source->resolve();
+	state::bind_buffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	state::bind_framebuffer(GL_READ_FRAMEBUFFER, source ? source->read_buffer() : 0U);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, GLsizei(width), GLsizei(height), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	state::bind_framebuffer(GL_READ_FRAMEBUFFER, renderer::current_target());
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.state = Pending;
+	next_      = (next_ + 1U) % count_;
+
+	profiler::end();
+	time_ += std::chrono::duration<double, std::milli>(profiler::clock::now() - start).count();
+}
+
+auto Capture::
+poll(
+	)
+	-> void
+{
+	auto const start = profiler::clock::now();
+
+	// Oldest first so frames reach the encoder in order
+	for (auto i = std::size_t(0U); i < count_; ++i)
+	{
+		auto& slot = slots_[(next_ + i) % count_];
+		if (slot.state.load() != Pending)
+			continue;
+
+		// Zero timeout only asks whether the transfer has finished
+		auto const status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0U);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+
+		auto job   = Job();
+		job.frame  = slot.frame;
+		job.image.width    = slot.width;
+		job.image.height   = slot.height;
+		job.image.channels = 4U;
+
+		if (persistent_)
+		{
+			// Encoder reads the mapped buffer and frees the slot itself
+			job.slot   = &slot;
+			slot.state = Encoding;
+		}
+		else
+		{
+			// Copy out on this thread so the buffer can be unmapped
+			auto const size = std::size_t(slot.width) * slot.height * 4U;
+			job.image.pixels.resize(size);
+
+			state::bind_buffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			auto const data = static_cast<std::uint8_t const*>(
+				glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(size), GL_MAP_READ_BIT));
+			if (data)
+				copy_flipped(data, job.image);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+			slot.state = Free;
+		}
+
+		submit(std::move(job));
+	}
+
+	time_ += std::chrono::duration<double, std::milli>(profiler::clock::now() - start).count();
+}
+
+auto Capture::
+flush(
+	)
+	-> void
+{
+	// Wait for outstanding transfers, then for the encoder to drain
+	for (auto i = std::size_t(0U); i < count_; ++i)
+		if (slots_[i].state.load() == Pending)
+			glClientWaitSync(slots_[i].fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	poll();
+
+	auto lock = std::unique_lock(mutex_);
+	condition_.wait(lock, [this]()
+	{
+		if (!jobs_.empty())
+			return false;
+
+		for (auto i = std::size_t(0U); i < count_; ++i)
+			if (slots_[i].state.load() == Encoding)
+				return false;
+
+		return true;
+	});
+}
+
+
+
+// Statistics
+auto Capture::
+captured(
+	) const
+	-> std::uint64_t
+{
+	return captured_.load();
+}
+
+auto Capture::
+dropped(
+	) const
+	-> std::uint64_t
+{
+	return dropped_;
+}
+
+auto Capture::
+render_time(
+	) const
+	-> double
+{
+	return time_;
+}
+
+
+
+// Encoder thread
+auto Capture::
+run(
+	)
+	-> void
+{
+	while (true)
+	{
+		auto job = Job();
+		{
+			auto lock = std::unique_lock(mutex_);
+			condition_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+			if (jobs_.empty())
+				return;
+
+			job = std::move(jobs_.front());
+			jobs_.pop_front();
+		}
+
+		// Persistent buffers are read directly, coherent mapping keeps them valid
+		if (job.slot)
+		{
+			job.image.pixels.resize(std::size_t(job.image.width) * job.image.height * 4U);
+			copy_flipped(job.slot->mapped, job.image);
+			job.slot->state = Free;
+		}
+
+		encode_(std::move(job.image), job.frame);
+		++captured_;
+
+		// Wake flush, which waits on slots as well as the queue
+		{
+			auto const lock = std::lock_guard(mutex_);
+		}
+		condition_.notify_all();
+	}
+}
+
+auto Capture::
+allocate(
+	Slot&             slot,
+	std::size_t const size
+	)
+	-> void
+{
+	if (slot.capacity == size)
+		return;
+
+	state::bind_buffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+
+	if (persistent_)
+	{
+		// Immutable storage has to be recreated to change size
+		if (slot.capacity != 0U)
+		{
+			state::release_buffer(slot.buffer);
+			glDeleteBuffers(1, &slot.buffer);
+			glGenBuffers(1, &slot.buffer);
+			state::bind_buffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		}
+
+		auto const flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_PIXEL_PACK_BUFFER, GLsizeiptr(size), nullptr, flags);
+		slot.mapped = static_cast<std::uint8_t*>(
+			glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(size), flags));
+	}
+	else
+		glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(size), nullptr, GL_STREAM_READ);
+
+	slot.capacity = size;
+}
+
+auto Capture::
+submit(
+	Job job
+	)
+	-> void
+{
+	{
+		auto const lock = std::lock_guard(mutex_);
+		jobs_.push_back(std::move(job));
+	}
+	condition_.notify_all();
+}
+
+} // namespace ogl
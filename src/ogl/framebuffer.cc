@@ -1,87 +1,354 @@
 #include <e3d/ogl/framebuffer.hh>
 
+#include <algorithm>
+#include <iostream>
+
+#include <e3d/ogl/state.hh>
+
 #include <glm/vec4.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 namespace ogl
 {
 
+// Details
+auto static
+bytes_per_pixel(
+	GLenum const format
+	)
+	-> std::size_t
+{
+	switch (format)
+	{
+		case GL_RGBA16F:
+		case GL_DEPTH32F_STENCIL8:
+			return 8U;
+		case GL_RGBA32F:
+			return 16U;
+		default:
+			return 4U;
+	}
+}
+
+auto static
+has_stencil(
+	GLenum const format
+	)
+	-> bool
+{
+	return format == GL_DEPTH24_STENCIL8
+		|| format == GL_DEPTH32F_STENCIL8;
+}
+
+// Pixel type to allocate a depth format with
+auto static
+depth_type(
+	GLenum const format
+	)
+	-> GLenum
+{
+	switch (format)
+	{
+		case GL_DEPTH24_STENCIL8:
+			return GL_UNSIGNED_INT_24_8;
+		case GL_DEPTH32F_STENCIL8:
+			return GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+		default:
+			return GL_FLOAT;
+	}
+}
+
+
+
+// Descriptor
+auto Framebuffer::Descriptor::
+operator==(
+	Descriptor const& other
+	) const
+	-> bool
+{
+	return width == other.width
+		&& height == other.height
+		&& is_compatible(other);
+}
+
+auto Framebuffer::Descriptor::
+is_compatible(
+	Descriptor const& other
+	) const
+	-> bool
+{
+	return colour == other.colour
+		&& depth == other.depth
+		&& samples == other.samples;
+}
+
+auto Framebuffer::Descriptor::
+supported(
+	) const
+	-> Descriptor
+{
+	auto result = *this;
+	if (samples <= 1U)
+		return result;
+
+	auto limit = GLint(0);
+	auto other = GLint(0);
+	glGetIntegerv(GL_MAX_SAMPLES, &limit);
+	glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &other);
+	limit = std::min(limit, other);
+	if (depth != 0U)
+	{
+		glGetIntegerv(GL_MAX_DEPTH_TEXTURE_SAMPLES, &other);
+		limit = std::min(limit, other);
+	}
+
+	result.samples = std::min(samples, GLuint(std::max(limit, 1)));
+	return result;
+}
+
+
+
 // Constructors
 Framebuffer::
 Framebuffer(
-	GLuint width,
-	GLuint height
+	GLuint const width,
+	GLuint const height
 	) :
-	width_(width),
-	height_(height),
-	frame_(Texture(width, height)),
-	depth_(Texture(width, height))
-{
-	glActiveTexture(GL_TEXTURE0);
+	Framebuffer(Descriptor{ width, height })
+{}
 
-	// Create frame image data
-	glBindTexture(frame_.type(), frame_.id());
-	glTexImage2D(
-		frame_.type(),
-		0,
-		GL_RGBA,
-		width,
-		height,
-		0,
-		GL_RGBA,
-		GL_UNSIGNED_BYTE,
-		nullptr);
-
-	glTexParameteri(frame_.type(), GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(frame_.type(), GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(frame_.type(), GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(frame_.type(), GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+Framebuffer::
+Framebuffer(
+	Descriptor const& descriptor
+	) :
+	descriptor_(descriptor.supported()),
+	colour_(descriptor.width, descriptor.height),
+	depth_(descriptor.width, descriptor.height),
+	resolved_(descriptor.width, descriptor.height)
+{
+	if (descriptor_.samples != descriptor.samples)
+		std::cerr << "WARNING: " <<
+			descriptor.samples << " samples requested, using " <<
+			descriptor_.samples << std::endl;
 
-	// Create depth image data
-	glBindTexture(depth_.type(), depth_.id());
-	glTexImage2D(
-		depth_.type(),
-		0,
-		GL_DEPTH_COMPONENT,
-		width,
-		height,
-		0,
-		GL_DEPTH_COMPONENT,
-		GL_FLOAT,
-		nullptr);
-
-	glTexParameteri(depth_.type(), GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(depth_.type(), GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(depth_.type(), GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(depth_.type(), GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameterfv(depth_.type(), GL_TEXTURE_BORDER_COLOR,
-		glm::value_ptr(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+	auto const multisampled = descriptor_.samples > 1U;
+	colour_.type_ = multisampled ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+	depth_.type_  = colour_.type_;
+	allocate();
 
 	// Create frame buffer and attach textures
 	glGenFramebuffers(1, &buffer_);
-	glBindFramebuffer(GL_FRAMEBUFFER, buffer_);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, frame_.type(), frame_.id(), 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depth_.type(), depth_.id(), 0);
+	state::bind_framebuffer(GL_FRAMEBUFFER, buffer_);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colour_.type(), colour_.id(), 0);
+	if (descriptor_.depth != 0U)
+		glFramebufferTexture2D(GL_FRAMEBUFFER,
+			has_stencil(descriptor_.depth) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+			depth_.type(), depth_.id(), 0);
 
 	// Set draw buffer
 	static GLenum draw_buffer = GL_COLOR_ATTACHMENT0;
 	glDrawBuffers(1, &draw_buffer);
 
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cerr << "ERROR: Framebuffer " <<
+			descriptor_.width << "x" << descriptor_.height << " (" <<
+			descriptor_.samples << " samples) is incomplete" << std::endl;
+
+	// Single sampled copy to read multisampled colour from
+	if (multisampled)
+	{
+		glGenFramebuffers(1, &resolve_);
+		state::bind_framebuffer(GL_FRAMEBUFFER, resolve_);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, resolved_.type(), resolved_.id(), 0);
+		glDrawBuffers(1, &draw_buffer);
+	}
+
 	// Unbind framebuffer
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	state::bind_framebuffer(GL_FRAMEBUFFER, 0);
 }
 
 Framebuffer::
 ~Framebuffer(
 	)
 {
-	glDeleteFramebuffers(1, &buffer_);
-	buffer_ = 0;
+	for (auto const buffer : { buffer_, resolve_ })
+	{
+		if (buffer == 0U)
+			continue;
+
+		state::release_framebuffer(buffer);
+		glDeleteFramebuffers(1, &buffer);
+	}
+	buffer_  = 0;
+	resolve_ = 0;
+}
+
+
+
+// Storage
+auto Framebuffer::
+resize(
+	GLuint const width,
+	GLuint const height
+	)
+	-> void
+{
+	if (width == descriptor_.width && height == descriptor_.height)
+		return;
+
+	descriptor_.width  = width;
+	descriptor_.height = height;
+	allocate();
+}
+
+auto Framebuffer::
+allocate(
+	)
+	-> void
+{
+	auto const width  = descriptor_.width;
+	auto const height = descriptor_.height;
+	auto const pixels = std::size_t(width) * height * std::max(descriptor_.samples, 1U);
+
+	// Create frame image data
+	colour_.width_      = width;
+	colour_.height_     = height;
+	colour_.format_     = descriptor_.colour;
+	colour_.size_bytes_ = pixels * bytes_per_pixel(descriptor_.colour);
+
+	state::bind_texture_for_edit(0U, colour_.type(), colour_.id());
+	if (colour_.type() == GL_TEXTURE_2D_MULTISAMPLE)
+		glTexImage2DMultisample(
+			colour_.type(),
+			GLsizei(descriptor_.samples),
+			descriptor_.colour,
+			GLsizei(width),
+			GLsizei(height),
+			GL_TRUE);
+	else
+	{
+		glTexImage2D(
+			colour_.type(),
+			0,
+			GLint(descriptor_.colour),
+			GLsizei(width),
+			GLsizei(height),
+			0,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			nullptr);
+
+		glTexParameteri(colour_.type(), GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(colour_.type(), GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(colour_.type(), GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(colour_.type(), GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	// Create depth image data
+	depth_.width_      = width;
+	depth_.height_     = height;
+	depth_.format_     = descriptor_.depth;
+	depth_.size_bytes_ = descriptor_.depth != 0U
+		? pixels * bytes_per_pixel(descriptor_.depth)
+		: 0U;
+
+	if (descriptor_.depth != 0U)
+	{
+		state::bind_texture_for_edit(0U, depth_.type(), depth_.id());
+		if (depth_.type() == GL_TEXTURE_2D_MULTISAMPLE)
+			glTexImage2DMultisample(
+				depth_.type(),
+				GLsizei(descriptor_.samples),
+				descriptor_.depth,
+				GLsizei(width),
+				GLsizei(height),
+				GL_TRUE);
+		else
+		{
+			glTexImage2D(
+				depth_.type(),
+				0,
+				GLint(descriptor_.depth),
+				GLsizei(width),
+				GLsizei(height),
+				0,
+				has_stencil(descriptor_.depth) ? GL_DEPTH_STENCIL : GL_DEPTH_COMPONENT,
+				depth_type(descriptor_.depth),
+				nullptr);
+
+			glTexParameteri(depth_.type(), GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(depth_.type(), GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(depth_.type(), GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(depth_.type(), GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameterfv(depth_.type(), GL_TEXTURE_BORDER_COLOR,
+				glm::value_ptr(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+		}
+	}
+
+	// Create resolve image data
+	resolved_.width_      = width;
+	resolved_.height_     = height;
+	resolved_.format_     = descriptor_.colour;
+	resolved_.size_bytes_ = 0U;
+
+	if (descriptor_.samples > 1U)
+	{
+		resolved_.size_bytes_ = std::size_t(width) * height * bytes_per_pixel(descriptor_.colour);
+
+		state::bind_texture_for_edit(0U, resolved_.type(), resolved_.id());
+		glTexImage2D(
+			resolved_.type(),
+			0,
+			GLint(descriptor_.colour),
+			GLsizei(width),
+			GLsizei(height),
+			0,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			nullptr);
+
+		glTexParameteri(resolved_.type(), GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(resolved_.type(), GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(resolved_.type(), GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(resolved_.type(), GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+}
+
+auto Framebuffer::
+resolve(
+	) const
+	-> void
+{
+	if (resolve_ == 0U)
+		return;
+
+	auto const draw = state::current_framebuffer(GL_DRAW_FRAMEBUFFER);
+	auto const read = state::current_framebuffer(GL_READ_FRAMEBUFFER);
+
+	state::bind_framebuffer(GL_READ_FRAMEBUFFER, buffer_);
+	state::bind_framebuffer(GL_DRAW_FRAMEBUFFER, resolve_);
+	glBlitFramebuffer(
+		0, 0, GLint(descriptor_.width), GLint(descriptor_.height),
+		0, 0, GLint(descriptor_.width), GLint(descriptor_.height),
+		GL_COLOR_BUFFER_BIT,
+		GL_NEAREST);
+
+	state::bind_framebuffer(GL_READ_FRAMEBUFFER, read);
+	state::bind_framebuffer(GL_DRAW_FRAMEBUFFER, draw);
 }
 
 
 
 // Detail
+auto Framebuffer::
+descriptor(
+	) const
+	-> Descriptor const&
+{
+	return descriptor_;
+}
+
 auto Framebuffer::
 buffer(
 	) const
@@ -90,12 +357,22 @@ buffer(
 	return buffer_;
 }
 
+auto Framebuffer::
+read_buffer(
+	) const
+	-> GLuint
+{
+	return resolve_ != 0U
+		? resolve_
+		: buffer_;
+}
+
 auto Framebuffer::
 width(
 	) const
 	-> GLuint
 {
-	return width_;
+	return descriptor_.width;
 }
 
 auto Framebuffer::
@@ -103,7 +380,15 @@ height(
 	) const
 	-> GLuint
 {
-	return height_;
+	return descriptor_.height;
+}
+
+auto Framebuffer::
+samples(
+	) const
+	-> GLuint
+{
+	return descriptor_.samples;
 }
 
 auto Framebuffer::
@@ -111,7 +396,9 @@ frame(
 	) const
 	-> Texture const&
 {
-	return frame_;
+	return resolve_ != 0U
+		? resolved_
+		: colour_;
 }
 
 auto Framebuffer::
@@ -122,6 +409,14 @@ depth(
 	return depth_;
 }
 
+auto Framebuffer::
+size_bytes(
+	) const
+	-> std::size_t
+{
+	return colour_.size_bytes() + depth_.size_bytes() + resolved_.size_bytes();
+}
+
 auto Framebuffer::
 is_valid(
 	) const
@@ -0,0 +1,147 @@
+#include <e3d/ogl/framebuffer_pool.hh>
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+
+
+namespace ogl
+{
+
+// Framebuffers
+auto FramebufferPool::
+acquire(
+	Framebuffer::Descriptor const& descriptor
+	)
+	-> Framebuffer&
+{
+	// Targets are created with the samples the context allows, match on those
+	auto const request = descriptor.supported();
+
+	// Exact match first, then anything that only needs new storage. Targets
+	// used this frame are not resized, or chains of differently sized
+	// targets would swap sizes every frame
+	auto best = entries_.end();
+	for (auto it = entries_.begin(); it != entries_.end(); ++it)
+	{
+		if (it->in_use || !it->framebuffer->descriptor().is_compatible(request))
+			continue;
+
+		if (it->framebuffer->descriptor() == request)
+		{
+			best = it;
+			break;
+		}
+
+		if (best == entries_.end() && it->used < frame_)
+			best = it;
+	}
+
+	if (best == entries_.end())
+	{
+		auto entry        = Entry();
+		entry.framebuffer = std::make_unique<Framebuffer>(descriptor);
+		entries_.push_back(std::move(entry));
+		best = std::prev(entries_.end());
+		++allocations_;
+	}
+	else if (best->framebuffer->descriptor() == request)
+		++reuses_;
+	else
+	{
+		best->framebuffer->resize(request.width, request.height);
+		++resizes_;
+	}
+
+	best->used   = frame_;
+	best->in_use = true;
+	return *best->framebuffer;
+}
+
+auto FramebufferPool::
+release(
+	Framebuffer const& framebuffer
+	)
+	-> void
+{
+	auto const it = std::find_if(entries_.begin(), entries_.end(),
+		[&framebuffer](Entry const& e) { return e.framebuffer.get() == &framebuffer; });
+
+	if (it == entries_.end())
+	{
+		std::cerr << "ERROR: Framebuffer released to a pool it does not belong to" << std::endl;
+		return;
+	}
+
+	it->used   = frame_;
+	it->in_use = false;
+}
+
+auto FramebufferPool::
+new_frame(
+	)
+	-> void
+{
+	++frame_;
+	entries_.erase(
+		std::remove_if(entries_.begin(), entries_.end(),
+			[this](Entry const& e) { return !e.in_use && frame_ - e.used > max_age; }),
+		entries_.end());
+}
+
+auto FramebufferPool::
+clear(
+	)
+	-> void
+{
+	entries_.clear();
+}
+
+
+
+// Statistics
+auto FramebufferPool::
+size(
+	) const
+	-> std::size_t
+{
+	return entries_.size();
+}
+
+auto FramebufferPool::
+size_bytes(
+	) const
+	-> std::size_t
+{
+	auto bytes = std::size_t(0U);
+	for (auto const& e : entries_)
+		bytes += e.framebuffer->size_bytes();
+	return bytes;
+}
+
+auto FramebufferPool::
+allocations(
+	) const
+	-> std::uint64_t
+{
+	return allocations_;
+}
+
+auto FramebufferPool::
+resizes(
+	) const
+	-> std::uint64_t
+{
+	return resizes_;
+}
+
+auto FramebufferPool::
+reuses(
+	) const
+	-> std::uint64_t
+{
+	return reuses_;
+}
+
+} // namespace ogl
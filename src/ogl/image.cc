@@ -0,0 +1,909 @@
+#include <e3d/ogl/image.hh>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+
+
+namespace ogl
+{
+
+// Rows
+auto Image::
+row(
+	std::uint32_t const y
+	)
+	-> std::uint8_t*
+{
+	return pixels.data() + std::size_t(y) * width * channels;
+}
+
+auto Image::
+row(
+	std::uint32_t const y
+	) const
+	-> std::uint8_t const*
+{
+	return pixels.data() + std::size_t(y) * width * channels;
+}
+
+auto Image::
+flip_vertical(
+	)
+	-> void
+{
+	auto const stride = std::size_t(width) * channels;
+	for (auto y = 0U; y < height / 2U; ++y)
+		std::swap_ranges(row(y), row(y) + stride, row(height - 1U - y));
+}
+
+auto Image::
+to_rgba(
+	) const
+	-> Image
+{
+	auto result   = Image();
+	result.width  = width;
+	result.height = height;
+	result.pixels.resize(std::size_t(width) * height * 4U);
+
+	auto const count = std::size_t(width) * height;
+	for (auto i = std::size_t(0U); i < count; ++i)
+	{
+		auto const source = pixels.data() + i * channels;
+		auto const target = result.pixels.data() + i * 4U;
+		auto const colour = channels >= 3U;
+
+		target[0] = source[0];
+		target[1] = colour ? source[1] : source[0];
+		target[2] = colour ? source[2] : source[0];
+		target[3] = channels == 4U
+			? source[3]
+			: channels == 2U
+				? source[1]
+				: 255U;
+	}
+
+	return result;
+}
+
+
+
+// PNG chunk checksum
+auto static
+crc32(
+	std::uint8_t const* data,
+	std::size_t         size,
+	std::uint32_t       crc = 0U
+	)
+	-> std::uint32_t
+{
+	auto static const table = []()
+	{
+		auto t = std::array<std::uint32_t, 256>();
+		for (auto i = 0U; i < 256U; ++i)
+		{
+			auto c = i;
+			for (auto k = 0; k < 8; ++k)
+				c = (c & 1U)
+					? 0xEDB88320U ^ (c >> 1U)
+					: c >> 1U;
+			t[i] = c;
+		}
+		return t;
+	}();
+
+	crc = ~crc;
+	for (auto i = std::size_t(0U); i < size; ++i)
+		crc = table[(crc ^ data[i]) & 0xFFU] ^ (crc >> 8U);
+	return ~crc;
+}
+
+// Zlib stream checksum
+auto static
+adler32(
+	std::vector<std::uint8_t> const& data
+	)
+	-> std::uint32_t
+{
+	auto a = std::uint32_t(1U);
+	auto b = std::uint32_t(0U);
+	for (auto const d : data)
+	{
+		a = (a + d) % 65521U;
+		b = (b + a) % 65521U;
+	}
+	return (b << 16U) | a;
+}
+
+auto static
+push_u32(
+	std::vector<std::uint8_t>& out,
+	std::uint32_t const        value
+	)
+	-> void
+{
+	out.push_back(std::uint8_t(value >> 24U));
+	out.push_back(std::uint8_t(value >> 16U));
+	out.push_back(std::uint8_t(value >> 8U));
+	out.push_back(std::uint8_t(value));
+}
+
+auto static
+write_chunk(
+	std::ofstream&                   file,
+	char const*                      type,
+	std::vector<std::uint8_t> const& data
+	)
+	-> void
+{
+	auto header = std::vector<std::uint8_t>();
+	push_u32(header, std::uint32_t(data.size()));
+	header.insert(header.end(), type, type + 4);
+
+	// Checksum covers type and data
+	auto crc = crc32(header.data() + 4, 4U);
+	crc      = crc32(data.data(), data.size(), crc);
+
+	auto footer = std::vector<std::uint8_t>();
+	push_u32(footer, crc);
+
+	file.write(reinterpret_cast<char const*>(header.data()), std::streamsize(header.size()));
+	file.write(reinterpret_cast<char const*>(data.data()), std::streamsize(data.size()));
+	file.write(reinterpret_cast<char const*>(footer.data()), std::streamsize(footer.size()));
+}
+
+
+
+// Write images
+auto
+write_ppm(
+	Image const&           image,
+	std::string_view const filename
+	)
+	-> bool
+{
+	auto file = std::ofstream(std::string(filename), std::ios::binary);
+	if (!file || image.channels < 3U)
+	{
+		std::cerr << "ERROR: Could not write PPM " <<
+			filename << std::endl;
+		return false;
+	}
+
+	file << "P6\n" << image.width << " " << image.height << "\n255\n";
+
+	auto line = std::vector<char>(std::size_t(image.width) * 3U);
+	for (auto y = 0U; y < image.height; ++y)
+	{
+		auto const source = image.row(y);
+		for (auto x = 0U; x < image.width; ++x)
+			for (auto c = 0U; c < 3U; ++c)
+				line[x * 3U + c] = char(source[x * image.channels + c]);
+		file.write(line.data(), std::streamsize(line.size()));
+	}
+
+	return bool(file);
+}
+
+auto
+write_png(
+	Image const&           image,
+	std::string_view const filename
+	)
+	-> bool
+{
+	auto file = std::ofstream(std::string(filename), std::ios::binary);
+	if (!file || image.channels < 1U || image.channels > 4U)
+	{
+		std::cerr << "ERROR: Could not write PNG " <<
+			filename << std::endl;
+		return false;
+	}
+
+	auto static const signature = std::array<std::uint8_t, 8>{
+		0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.write(reinterpret_cast<char const*>(signature.data()), signature.size());
+
+	// Header, colour type by channel count (grey, grey alpha, rgb, rgba)
+	auto static const colour_types = std::array<std::uint8_t, 4>{ 0, 4, 2, 6 };
+	auto header = std::vector<std::uint8_t>();
+	push_u32(header, image.width);
+	push_u32(header, image.height);
+	header.push_back(8U);
+	header.push_back(colour_types[image.channels - 1U]);
+	header.push_back(0U);
+	header.push_back(0U);
+	header.push_back(0U);
+	write_chunk(file, "IHDR", header);
+
+	// Scanlines, each prefixed with filter type none
+	auto const stride = std::size_t(image.width) * image.channels;
+	auto raw = std::vector<std::uint8_t>();
+	raw.reserve((stride + 1U) * image.height);
+	for (auto y = 0U; y < image.height; ++y)
+	{
+		raw.push_back(0U);
+		raw.insert(raw.end(), image.row(y), image.row(y) + stride);
+	}
+
+	// Zlib stream of stored (uncompressed) deflate blocks
+	auto data = std::vector<std::uint8_t>{ 0x78, 0x01 };
+	data.reserve(raw.size() + raw.size() / 65535U * 5U + 16U);
+	auto offset = std::size_t(0U);
+	do
+	{
+		auto const length = std::min<std::size_t>(raw.size() - offset, 65535U);
+		auto const last   = offset + length == raw.size();
+
+		data.push_back(last ? 1U : 0U);
+		data.push_back(std::uint8_t(length));
+		data.push_back(std::uint8_t(length >> 8U));
+		data.push_back(std::uint8_t(~length));
+		data.push_back(std::uint8_t(~length >> 8U));
+		data.insert(data.end(), raw.begin() + std::ptrdiff_t(offset), raw.begin() + std::ptrdiff_t(offset + length));
+
+		offset += length;
+	} while (offset < raw.size());
+	push_u32(data, adler32(raw));
+	write_chunk(file, "IDAT", data);
+
+	write_chunk(file, "IEND", {});
+	return bool(file);
+}
+
+auto
+write_image(
+	Image const&           image,
+	std::string_view const filename
+	)
+	-> bool
+{
+	auto const extension = filename.substr(filename.find_last_of('.') + 1U);
+	if (extension == "png")
+		return write_png(image, filename);
+	if (extension == "ppm")
+		return write_ppm(image, filename);
+
+	std::cerr << "ERROR: Unknown image format " <<
+		filename << std::endl;
+	return false;
+}
+
+
+
+// Whole file as bytes
+auto static
+read_bytes(
+	std::string_view const filename
+	)
+	-> std::optional<std::vector<std::uint8_t>>
+{
+	auto file = std::ifstream(std::string(filename), std::ios::binary);
+	if (!file)
+		return std::nullopt;
+
+	return std::vector<std::uint8_t>(
+		std::istreambuf_iterator<char>(file),
+		std::istreambuf_iterator<char>());
+}
+
+auto static
+read_u32(
+	std::uint8_t const* data
+	)
+	-> std::uint32_t
+{
+	return
+		std::uint32_t(data[0]) << 24U |
+		std::uint32_t(data[1]) << 16U |
+		std::uint32_t(data[2]) << 8U |
+		std::uint32_t(data[3]);
+}
+
+
+
+// Deflate decoder (RFC 1951), canonical Huffman codes decoded bit by bit
+class Inflater
+{
+	struct Huffman
+	{
+		std::array<std::uint16_t, 16>  counts  = {};
+		std::array<std::uint16_t, 288> symbols = {};
+	};
+
+	std::uint8_t const* data_;
+	std::size_t         size_;
+	std::size_t         position_ = 0U;
+	std::uint32_t       bits_     = 0U;
+	std::uint32_t       count_    = 0U;
+	bool                error_    = false;
+
+public:
+
+	Inflater(
+		std::uint8_t const* const data,
+		std::size_t         const size
+		) :
+		data_(data),
+		size_(size)
+	{}
+
+	auto
+	inflate(
+		std::vector<std::uint8_t>& out
+		)
+		-> bool
+	{
+		auto last = false;
+		while (!last && !error_)
+		{
+			last = bits(1U);
+			auto const type = bits(2U);
+
+			if (type == 0U)
+				stored(out);
+			else if (type == 1U)
+				fixed(out);
+			else if (type == 2U)
+				dynamic(out);
+			else
+				error_ = true;
+		}
+
+		return !error_;
+	}
+
+private:
+
+	auto
+	bits(
+		std::uint32_t const needed
+		)
+		-> std::uint32_t
+	{
+		while (count_ < needed)
+		{
+			if (position_ == size_)
+			{
+				error_ = true;
+				return 0U;
+			}
+
+			bits_  |= std::uint32_t(data_[position_++]) << count_;
+			count_ += 8U;
+		}
+
+		auto const value = bits_ & ((1U << needed) - 1U);
+		bits_  >>= needed;
+		count_  -= needed;
+		return value;
+	}
+
+	auto static
+	build(
+		Huffman&             huffman,
+		std::uint8_t const*  lengths,
+		std::size_t          count
+		)
+		-> void
+	{
+		huffman.counts.fill(0U);
+		for (auto i = std::size_t(0U); i < count; ++i)
+			++huffman.counts[lengths[i]];
+		huffman.counts[0] = 0U;
+
+		auto offsets = std::array<std::uint16_t, 16>();
+		for (auto i = 1U; i < 15U; ++i)
+			offsets[i + 1U] = std::uint16_t(offsets[i] + huffman.counts[i]);
+
+		for (auto i = std::size_t(0U); i < count; ++i)
+			if (lengths[i] != 0U)
+				huffman.symbols[offsets[lengths[i]]++] = std::uint16_t(i);
+	}
+
+	auto
+	decode(
+		Huffman const& huffman
+		)
+		-> std::uint32_t
+	{
+		auto code  = 0;
+		auto first = 0;
+		auto index = 0;
+		for (auto length = 1; length < 16; ++length)
+		{
+			code |= int(bits(1U));
+			auto const count = int(huffman.counts[std::size_t(length)]);
+			if (code - count < first)
+				return huffman.symbols[std::size_t(index + code - first)];
+
+			index += count;
+			first  = (first + count) << 1;
+			code <<= 1;
+		}
+
+		error_ = true;
+		return 0U;
+	}
+
+	auto
+	stored(
+		std::vector<std::uint8_t>& out
+		)
+		-> void
+	{
+		// Byte aligned length and its complement
+		bits_  = 0U;
+		count_ = 0U;
+		if (position_ + 4U > size_)
+		{
+			error_ = true;
+			return;
+		}
+
+		auto const length = std::size_t(data_[position_] | data_[position_ + 1U] << 8U);
+		position_ += 4U;
+		if (position_ + length > size_)
+		{
+			error_ = true;
+			return;
+		}
+
+		out.insert(out.end(), data_ + position_, data_ + position_ + length);
+		position_ += length;
+	}
+
+	auto
+	codes(
+		std::vector<std::uint8_t>& out,
+		Huffman const&             lengths,
+		Huffman const&             distances
+		)
+		-> void
+	{
+		auto static constexpr length_base = std::array<std::uint16_t, 29>{
+			3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+			35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		auto static constexpr length_extra = std::array<std::uint8_t, 29>{
+			0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+			3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		auto static constexpr distance_base = std::array<std::uint16_t, 30>{
+			1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+			257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+			8193, 12289, 16385, 24577 };
+		auto static constexpr distance_extra = std::array<std::uint8_t, 30>{
+			0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+			7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+		while (!error_)
+		{
+			auto const symbol = decode(lengths);
+			if (symbol < 256U)
+				out.push_back(std::uint8_t(symbol));
+			else if (symbol == 256U)
+				return;
+			else
+			{
+				// Length extra bits come before the distance code
+				auto const l = symbol - 257U;
+				if (l >= 29U)
+				{
+					error_ = true;
+					return;
+				}
+				auto const length = length_base[l] + bits(length_extra[l]);
+
+				auto const d = decode(distances);
+				if (d >= 30U)
+				{
+					error_ = true;
+					return;
+				}
+				auto const distance = distance_base[d] + bits(distance_extra[d]);
+				if (distance > out.size())
+				{
+					error_ = true;
+					return;
+				}
+
+				// Copies may overlap the bytes they produce
+				auto const from = out.size() - distance;
+				for (auto i = std::size_t(0U); i < length; ++i)
+					out.push_back(out[from + i]);
+			}
+		}
+	}
+
+	auto
+	fixed(
+		std::vector<std::uint8_t>& out
+		)
+		-> void
+	{
+		auto static const tables = []()
+		{
+			auto lengths = std::array<std::uint8_t, 320>();
+			for (auto i = 0U; i < 144U; ++i) lengths[i] = 8U;
+			for (auto i = 144U; i < 256U; ++i) lengths[i] = 9U;
+			for (auto i = 256U; i < 280U; ++i) lengths[i] = 7U;
+			for (auto i = 280U; i < 288U; ++i) lengths[i] = 8U;
+			for (auto i = 288U; i < 320U; ++i) lengths[i] = 5U;
+
+			auto result = std::array<Huffman, 2>();
+			build(result[0], lengths.data(), 288U);
+			build(result[1], lengths.data() + 288U, 30U);
+			return result;
+		}();
+
+		codes(out, tables[0], tables[1]);
+	}
+
+	auto
+	dynamic(
+		std::vector<std::uint8_t>& out
+		)
+		-> void
+	{
+		auto static constexpr order = std::array<std::uint8_t, 19>{
+			16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+		auto const literals  = bits(5U) + 257U;
+		auto const distances = bits(5U) + 1U;
+		auto const code_count = bits(4U) + 4U;
+
+		auto lengths = std::array<std::uint8_t, 320>();
+		for (auto i = 0U; i < code_count; ++i)
+			lengths[order[i]] = std::uint8_t(bits(3U));
+
+		auto code = Huffman();
+		build(code, lengths.data(), 19U);
+
+		// Literal and distance code lengths, with repeats
+		lengths.fill(0U);
+		for (auto i = 0U; i < literals + distances && !error_; )
+		{
+			auto const symbol = decode(code);
+			if (symbol < 16U)
+			{
+				lengths[i++] = std::uint8_t(symbol);
+				continue;
+			}
+
+			auto value  = std::uint8_t(0U);
+			auto repeat = 0U;
+			if (symbol == 16U)
+			{
+				if (i == 0U)
+				{
+					error_ = true;
+					return;
+				}
+				value  = lengths[i - 1U];
+				repeat = 3U + bits(2U);
+			}
+			else if (symbol == 17U)
+				repeat = 3U + bits(3U);
+			else
+				repeat = 11U + bits(7U);
+
+			if (i + repeat > literals + distances)
+			{
+				error_ = true;
+				return;
+			}
+
+			while (repeat-- > 0U)
+				lengths[i++] = value;
+		}
+
+		auto literal  = Huffman();
+		auto distance = Huffman();
+		build(literal, lengths.data(), literals);
+		build(distance, lengths.data() + literals, distances);
+		codes(out, literal, distance);
+	}
+};
+
+
+
+// Read images
+auto
+read_ppm(
+	std::string_view const filename
+	)
+	-> std::optional<Image>
+{
+	auto const bytes = read_bytes(filename);
+	if (!bytes || bytes->size() < 2U || (*bytes)[0] != 'P' || ((*bytes)[1] != '6' && (*bytes)[1] != '5'))
+	{
+		std::cerr << "ERROR: Could not read PPM " <<
+			filename << std::endl;
+		return std::nullopt;
+	}
+
+	// Header fields are separated by whitespace and may have comments
+	auto position = std::size_t(2U);
+	auto const field = [&bytes, &position]()
+	{
+		auto const& b = *bytes;
+		while (position < b.size() && (std::isspace(b[position]) || b[position] == '#'))
+		{
+			if (b[position] == '#')
+				while (position < b.size() && b[position] != '\n')
+					++position;
+			else
+				++position;
+		}
+
+		auto value = 0U;
+		while (position < b.size() && std::isdigit(b[position]))
+			value = value * 10U + (b[position++] - '0');
+		return value;
+	};
+
+	auto image     = Image();
+	image.channels = (*bytes)[1] == '6' ? 3U : 1U;
+	image.width    = field();
+	image.height   = field();
+	auto const max = field();
+	++position;
+
+	auto const size = std::size_t(image.width) * image.height * image.channels;
+	if (max != 255U || position + size > bytes->size())
+	{
+		std::cerr << "ERROR: Unsupported PPM " <<
+			filename << std::endl;
+		return std::nullopt;
+	}
+
+	image.pixels.assign(bytes->begin() + std::ptrdiff_t(position), bytes->begin() + std::ptrdiff_t(position + size));
+	return image;
+}
+
+auto
+read_tga(
+	std::string_view const filename
+	)
+	-> std::optional<Image>
+{
+	auto const bytes = read_bytes(filename);
+	if (!bytes || bytes->size() < 18U)
+	{
+		std::cerr << "ERROR: Could not read TGA " <<
+			filename << std::endl;
+		return std::nullopt;
+	}
+
+	auto const& b         = *bytes;
+	auto const  type      = b[2];
+	auto const  depth     = b[16];
+	auto const  top_first = (b[17] & 0x20U) != 0U;
+	auto const  rle       = type == 10U || type == 11U;
+
+	// Colour mapped images are not supported
+	if (b[1] != 0U || (type != 2U && type != 3U && type != 10U && type != 11U)
+		|| (depth != 8U && depth != 24U && depth != 32U))
+	{
+		std::cerr << "ERROR: Unsupported TGA " <<
+			filename << std::endl;
+		return std::nullopt;
+	}
+
+	auto image     = Image();
+	image.width    = std::uint32_t(b[12] | b[13] << 8U);
+	image.height   = std::uint32_t(b[14] | b[15] << 8U);
+	image.channels = depth / 8U;
+	image.pixels.resize(std::size_t(image.width) * image.height * image.channels);
+
+	auto       position = std::size_t(18U) + b[0];
+	auto const channels = std::size_t(image.channels);
+	auto const count    = std::size_t(image.width) * image.height;
+
+	// Pixels are stored as BGR(A)
+	auto const copy = [&image, &b, channels](std::size_t const pixel, std::size_t const from)
+	{
+		auto const target = image.pixels.data() + pixel * channels;
+		for (auto c = std::size_t(0U); c < channels; ++c)
+			target[c] = b[from + c];
+		if (channels >= 3U)
+			std::swap(target[0], target[2]);
+	};
+
+	for (auto pixel = std::size_t(0U); pixel < count; )
+	{
+		auto run    = std::size_t(1U);
+		auto repeat = false;
+		if (rle)
+		{
+			if (position >= b.size())
+				break;
+			repeat = (b[position] & 0x80U) != 0U;
+			run    = (b[position] & 0x7FU) + 1U;
+			++position;
+		}
+
+		auto const needed = repeat ? channels : run * channels;
+		if (position + needed > b.size() || pixel + run > count)
+		{
+			std::cerr << "ERROR: Truncated TGA " <<
+				filename << std::endl;
+			return std::nullopt;
+		}
+
+		for (auto i = std::size_t(0U); i < run; ++i)
+			copy(pixel + i, repeat ? position : position + i * channels);
+
+		position += needed;
+		pixel    += run;
+	}
+
+	// Rows are stored from the bottom unless flagged
+	if (!top_first)
+		image.flip_vertical();
+	return image;
+}
+
+auto
+read_png(
+	std::string_view const filename
+	)
+	-> std::optional<Image>
+{
+	auto static const signature = std::array<std::uint8_t, 8>{
+		0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	auto const bytes = read_bytes(filename);
+	if (!bytes || bytes->size() < 8U || !std::equal(signature.begin(), signature.end(), bytes->begin()))
+	{
+		std::cerr << "ERROR: Could not read PNG " <<
+			filename << std::endl;
+		return std::nullopt;
+	}
+
+	// Chunks
+	auto const& b          = *bytes;
+	auto        image      = Image();
+	auto        colour     = std::uint8_t(0U);
+	auto        depth      = std::uint8_t(0U);
+	auto        interlace  = std::uint8_t(0U);
+	auto        palette    = std::vector<std::uint8_t>();
+	auto        alpha      = std::vector<std::uint8_t>();
+	auto        compressed = std::vector<std::uint8_t>();
+
+	for (auto position = std::size_t(8U); position + 12U <= b.size(); )
+	{
+		auto const length = std::size_t(read_u32(&b[position]));
+		auto const type   = std::string(reinterpret_cast<char const*>(&b[position + 4U]), 4U);
+		auto const data   = &b[position + 8U];
+		if (position + 12U + length > b.size())
+			break;
+
+		if (type == "IHDR" && length >= 13U)
+		{
+			image.width  = read_u32(data);
+			image.height = read_u32(data + 4U);
+			depth        = data[8];
+			colour       = data[9];
+			interlace    = data[12];
+		}
+		else if (type == "PLTE")
+			palette.assign(data, data + length);
+		else if (type == "tRNS")
+			alpha.assign(data, data + length);
+		else if (type == "IDAT")
+			compressed.insert(compressed.end(), data, data + length);
+		else if (type == "IEND")
+			break;
+
+		position += 12U + length;
+	}
+
+	// Samples per pixel by colour type (grey, rgb, palette, grey alpha, rgba)
+	auto static constexpr samples = std::array<std::uint32_t, 7>{ 1, 0, 3, 1, 2, 0, 4 };
+	if (depth != 8U || interlace != 0U || colour > 6U || samples[colour] == 0U
+		|| (colour == 3U && palette.empty()) || compressed.size() < 2U)
+	{
+		std::cerr << "ERROR: Unsupported PNG " <<
+			filename << std::endl;
+		return std::nullopt;
+	}
+
+	// Zlib header, then deflate
+	auto raw      = std::vector<std::uint8_t>();
+	auto inflater = Inflater(compressed.data() + 2U, compressed.size() - 2U);
+	auto const bpp    = std::size_t(samples[colour]);
+	auto const stride = std::size_t(image.width) * bpp;
+	raw.reserve((stride + 1U) * image.height);
+	if (!inflater.inflate(raw) || raw.size() < (stride + 1U) * image.height)
+	{
+		std::cerr << "ERROR: Corrupt PNG " <<
+			filename << std::endl;
+		return std::nullopt;
+	}
+
+	// Undo the per row filters
+	auto pixels = std::vector<std::uint8_t>(stride * image.height);
+	for (auto y = std::size_t(0U); y < image.height; ++y)
+	{
+		auto const filter   = raw[y * (stride + 1U)];
+		auto const source   = &raw[y * (stride + 1U) + 1U];
+		auto const target   = &pixels[y * stride];
+		auto const previous = y > 0U ? &pixels[(y - 1U) * stride] : nullptr;
+
+		for (auto x = std::size_t(0U); x < stride; ++x)
+		{
+			auto const a = x >= bpp ? int(target[x - bpp]) : 0;
+			auto const u = previous ? int(previous[x]) : 0;
+			auto const c = previous && x >= bpp ? int(previous[x - bpp]) : 0;
+
+			auto predictor = 0;
+			switch (filter)
+			{
+				case 1: predictor = a;           break;
+				case 2: predictor = u;           break;
+				case 3: predictor = (a + u) / 2; break;
+				case 4:
+				{
+					auto const p  = a + u - c;
+					auto const pa = std::abs(p - a);
+					auto const pb = std::abs(p - u);
+					auto const pc = std::abs(p - c);
+					predictor = pa <= pb && pa <= pc ? a : pb <= pc ? u : c;
+					break;
+				}
+				default: break;
+			}
+
+			target[x] = std::uint8_t(source[x] + predictor);
+		}
+	}
+
+	// Expand palette indices
+	if (colour == 3U)
+	{
+		image.channels = alpha.empty() ? 3U : 4U;
+		image.pixels.resize(std::size_t(image.width) * image.height * image.channels);
+		for (auto i = std::size_t(0U); i < pixels.size(); ++i)
+		{
+			auto const index  = std::size_t(pixels[i]);
+			auto const target = &image.pixels[i * image.channels];
+			for (auto c = std::size_t(0U); c < 3U; ++c)
+				target[c] = index * 3U + c < palette.size() ? palette[index * 3U + c] : 0U;
+			if (image.channels == 4U)
+				target[3] = index < alpha.size() ? alpha[index] : 255U;
+		}
+		return image;
+	}
+
+	image.channels = samples[colour];
+	image.pixels   = std::move(pixels);
+	return image;
+}
+
+auto
+read_image(
+	std::string_view const filename
+	)
+	-> std::optional<Image>
+{
+	auto const extension = filename.substr(filename.find_last_of('.') + 1U);
+	if (extension == "png" || extension == "PNG")
+		return read_png(filename);
+	if (extension == "tga" || extension == "TGA")
+		return read_tga(filename);
+	if (extension == "ppm" || extension == "pgm")
+		return read_ppm(filename);
+
+	std::cerr << "ERROR: Unknown image format " <<
+		filename << std::endl;
+	return std::nullopt;
+}
+
+} // namespace ogl
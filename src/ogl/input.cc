@@ -0,0 +1,98 @@
+#include <e3d/ogl/input.hh>
+
+#include <atomic>
+
+#include <e3d/ogl/ring_buffer.hh>
+
+
+
+namespace ogl::input
+{
+
+// Events from the window waiting for a tick
+auto static events_  = RingBuffer<Event, 1024U>();
+auto static dropped_ = std::atomic<std::uint64_t>(0U);
+
+// Consumer side
+auto static state_ = State();
+
+
+
+// Events
+auto
+push(
+	Event const& event
+	)
+	-> void
+{
+	if (!events_.push(event))
+		dropped_.fetch_add(1U, std::memory_order_relaxed);
+}
+
+auto
+advance(
+	renderer::time_point const end
+	)
+	-> State const&
+{
+	// Held keys carry over, everything else is per tick
+	state_.pressed  = renderer::keyboard_t{ false };
+	state_.released = renderer::keyboard_t{ false };
+	state_.aim      = glm::vec2(0.0F);
+	state_.scroll   = 0.0F;
+	state_.events   = 0U;
+
+	for (auto event = events_.front(); event && event->time <= end; event = events_.front())
+	{
+		switch (event->type)
+		{
+		case Type::Key:
+			if (event->key >= 0 && std::size_t(event->key) < state_.down.size())
+			{
+				auto const key = std::size_t(event->key);
+				if (event->action == GLFW_PRESS)
+				{
+					state_.down[key]    = true;
+					state_.pressed[key] = true;
+				}
+				else if (event->action == GLFW_RELEASE)
+				{
+					state_.down[key]     = false;
+					state_.released[key] = true;
+				}
+			}
+			break;
+
+		case Type::Cursor:
+			state_.aim += event->offset;
+			break;
+
+		case Type::Scroll:
+			state_.scroll += event->offset.y;
+			break;
+		}
+
+		++state_.events;
+		events_.pop();
+	}
+
+	return state_;
+}
+
+auto
+state(
+	)
+	-> State const&
+{
+	return state_;
+}
+
+auto
+dropped(
+	)
+	-> std::uint64_t
+{
+	return dropped_.load(std::memory_order_relaxed);
+}
+
+} // namespace ogl::input
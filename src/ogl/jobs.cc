@@ -0,0 +1,461 @@
+#include <e3d/ogl/jobs.hh>
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+
+
+
+namespace ogl::jobs
+{
+
+// Types
+struct Job
+{
+	job_function function;
+	Counter*     counter = nullptr;
+};
+
+// Chase-Lev work-stealing deque of fixed capacity, only the owner pushes and
+// pops (at the bottom), any thread steals (from the top)
+class Deque
+{
+	auto static constexpr capacity_ = std::int64_t(4096);
+
+	alignas(64) std::atomic<std::int64_t> top_    = 0;
+	alignas(64) std::atomic<std::int64_t> bottom_ = 0;
+	std::array<std::atomic<Job*>, capacity_> buffer_;
+
+public:
+
+	// False when full
+	auto
+	push(
+		Job* const job
+		)
+		-> bool
+	{
+		auto const b = bottom_.load(std::memory_order_relaxed);
+		auto const t = top_.load(std::memory_order_acquire);
+		if (b - t >= capacity_)
+			return false;
+
+		buffer_[std::size_t(b % capacity_)].store(job, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom_.store(b + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	auto
+	pop(
+		)
+		-> Job*
+	{
+		auto const b = bottom_.load(std::memory_order_relaxed) - 1;
+		bottom_.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		auto t = top_.load(std::memory_order_relaxed);
+
+		if (t > b)
+		{
+			bottom_.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		auto job = buffer_[std::size_t(b % capacity_)].load(std::memory_order_relaxed);
+		if (t == b)
+		{
+			// Last job, race the thieves for it
+			if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				job = nullptr;
+			bottom_.store(b + 1, std::memory_order_relaxed);
+		}
+
+		return job;
+	}
+
+	auto
+	steal(
+		)
+		-> Job*
+	{
+		auto t = top_.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		auto const b = bottom_.load(std::memory_order_acquire);
+		if (t >= b)
+			return nullptr;
+
+		auto const job = buffer_[std::size_t(t % capacity_)].load(std::memory_order_relaxed);
+		if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+
+		return job;
+	}
+};
+
+struct alignas(64) Worker
+{
+	Deque                      deque;
+	std::thread                thread;
+	std::atomic<std::uint64_t> executed = 0U;
+	std::atomic<std::uint64_t> stolen   = 0U;
+};
+
+
+
+// Scheduler
+auto static constexpr none_ = ~std::size_t(0U);
+
+auto static thread_local index_ = none_;
+
+class Scheduler
+{
+public:
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	bool                                 started = false;
+	std::atomic<bool>                    stopping = false;
+
+	// Jobs from threads outside the scheduler
+	std::mutex        injected_mutex;
+	std::deque<Job*>  injected;
+
+	// Idle workers sleep until something is queued
+	std::atomic<std::int64_t> queued   = 0;
+	std::atomic<std::size_t>  sleeping = 0U;
+	std::mutex                sleep_mutex;
+	std::condition_variable   condition;
+
+	auto
+	submit(
+		Job* const job
+		)
+		-> void
+	{
+		queued.fetch_add(1);
+
+		if (index_ != none_)
+		{
+			// A full deque runs the job right away rather than grow
+			if (!workers[index_]->deque.push(job))
+			{
+				queued.fetch_sub(1);
+				execute(job);
+				return;
+			}
+		}
+		else
+		{
+			auto const lock = std::lock_guard(injected_mutex);
+			injected.push_back(job);
+		}
+
+		if (sleeping.load() > 0U)
+		{
+			// Taking the mutex orders this against a worker about to sleep
+			{
+				auto const lock = std::lock_guard(sleep_mutex);
+			}
+			condition.notify_one();
+		}
+	}
+
+	auto
+	find(
+		)
+		-> Job*
+	{
+		auto job = static_cast<Job*>(nullptr);
+		if (index_ != none_)
+			job = workers[index_]->deque.pop();
+
+		if (!job)
+		{
+			auto const lock = std::lock_guard(injected_mutex);
+			if (!injected.empty())
+			{
+				job = injected.front();
+				injected.pop_front();
+			}
+		}
+
+		// Visit the others starting from the next one, so thieves spread out
+		auto const start = index_ == none_ ? 0U : index_ + 1U;
+		for (auto i = std::size_t(0U); !job && i < workers.size(); ++i)
+		{
+			auto const victim = (start + i) % workers.size();
+			if (victim == index_)
+				continue;
+
+			job = workers[victim]->deque.steal();
+			if (job && index_ != none_)
+				workers[index_]->stolen.fetch_add(1U, std::memory_order_relaxed);
+		}
+
+		if (job)
+			queued.fetch_sub(1);
+
+		return job;
+	}
+
+	auto
+	execute(
+		Job* const job
+		)
+		-> void
+	{
+		job->function();
+		if (index_ != none_)
+			workers[index_]->executed.fetch_add(1U, std::memory_order_relaxed);
+
+		if (job->counter)
+			finish(*job->counter);
+
+		delete job;
+	}
+
+	auto
+	finish(
+		Counter& counter
+		)
+		-> void
+	{
+		// Decrement under the lock, wait() takes it once more before letting
+		// the owner destroy the counter
+		auto released = std::vector<Job*>();
+		{
+			auto const lock = std::lock_guard(counter.mutex_);
+			if (counter.pending_.fetch_sub(1U, std::memory_order_acq_rel) != 1U)
+				return;
+
+			released.swap(counter.waiting_);
+		}
+
+		for (auto const job : released)
+			submit(job);
+	}
+
+	auto
+	enqueue(
+		Job*     const job,
+		Counter* const after
+		)
+		-> void
+	{
+		if (job->counter)
+			job->counter->pending_.fetch_add(1U, std::memory_order_relaxed);
+
+		if (after)
+		{
+			auto const lock = std::lock_guard(after->mutex_);
+			if (after->pending_.load(std::memory_order_acquire) > 0U)
+			{
+				after->waiting_.push_back(job);
+				return;
+			}
+		}
+
+		submit(job);
+	}
+
+	auto
+	run(
+		std::size_t const index
+		)
+		-> void
+	{
+		index_ = index;
+
+		while (!stopping.load(std::memory_order_relaxed))
+		{
+			if (auto const job = find())
+			{
+				execute(job);
+				continue;
+			}
+
+			auto lock = std::unique_lock(sleep_mutex);
+			sleeping.fetch_add(1U);
+			condition.wait(lock, [this]{ return stopping.load() || queued.load() > 0; });
+			sleeping.fetch_sub(1U);
+		}
+
+		// Jobs pushed by running jobs land on this deque, finish them rather
+		// than leak them
+		while (auto const job = find())
+			execute(job);
+	}
+
+	auto
+	pending(
+		Counter& counter
+		) const
+		-> bool
+	{
+		if (counter.pending_.load(std::memory_order_acquire) > 0U)
+			return true;
+
+		auto const lock = std::lock_guard(counter.mutex_);
+		return counter.pending_.load(std::memory_order_relaxed) > 0U;
+	}
+};
+
+auto static scheduler_ = Scheduler();
+
+
+
+// Workers
+auto
+start(
+	std::size_t workers
+	)
+	-> void
+{
+	if (scheduler_.started)
+		return;
+
+	if (workers == 0U)
+		workers = std::max(std::thread::hardware_concurrency(), 2U) - 1U;
+
+	// The caller is worker zero
+	index_ = 0U;
+	for (auto i = std::size_t(0U); i <= workers; ++i)
+		scheduler_.workers.push_back(std::make_unique<Worker>());
+
+	scheduler_.stopping = false;
+	scheduler_.started  = true;
+	for (auto i = std::size_t(1U); i <= workers; ++i)
+		scheduler_.workers[i]->thread = std::thread(&Scheduler::run, &scheduler_, i);
+}
+
+auto
+shutdown(
+	)
+	-> void
+{
+	if (!scheduler_.started)
+		return;
+
+	// Drain on this thread, workers keep helping until told to stop
+	while (auto const job = scheduler_.find())
+		scheduler_.execute(job);
+
+	{
+		auto const lock = std::lock_guard(scheduler_.sleep_mutex);
+		scheduler_.stopping = true;
+	}
+	scheduler_.condition.notify_all();
+
+	for (auto& worker : scheduler_.workers)
+		if (worker->thread.joinable())
+			worker->thread.join();
+
+	// Whatever other threads submitted while the workers wound down
+	while (auto const job = scheduler_.find())
+		scheduler_.execute(job);
+
+	scheduler_.workers.clear();
+	scheduler_.started = false;
+	index_             = none_;
+}
+
+auto
+concurrency(
+	)
+	-> std::size_t
+{
+	return std::max(scheduler_.workers.size(), std::size_t(1U));
+}
+
+
+
+// Jobs
+auto
+run(
+	job_function   job,
+	Counter* const counter,
+	Counter* const after
+	)
+	-> void
+{
+	if (!scheduler_.started)
+	{
+		job();
+		return;
+	}
+
+	scheduler_.enqueue(new Job{ std::move(job), counter }, after);
+}
+
+auto
+wait(
+	Counter& counter
+	)
+	-> void
+{
+	while (scheduler_.pending(counter))
+	{
+		if (auto const job = scheduler_.find())
+			scheduler_.execute(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+auto
+parallel_for(
+	std::size_t           const begin,
+	std::size_t           const end,
+	std::size_t                 grain,
+	range_function        const& function
+	)
+	-> void
+{
+	if (begin >= end)
+		return;
+
+	auto const count = end - begin;
+	if (grain == 0U)
+		grain = std::max(count / (concurrency() * 4U), std::size_t(1U));
+
+	if (count <= grain || !scheduler_.started)
+	{
+		function(begin, end);
+		return;
+	}
+
+	// Queue every range but the first, which this thread takes
+	auto counter = Counter();
+	for (auto first = begin + grain; first < end; first += grain)
+	{
+		auto const last = std::min(first + grain, end);
+		run([&function, first, last]{ function(first, last); }, &counter);
+	}
+
+	function(begin, begin + grain);
+	wait(counter);
+}
+
+
+
+// Statistics
+auto
+stats(
+	)
+	-> Stats
+{
+	auto result    = Stats();
+	result.workers = scheduler_.workers.size();
+	for (auto const& worker : scheduler_.workers)
+	{
+		result.executed += worker->executed.load(std::memory_order_relaxed);
+		result.stolen   += worker->stolen.load(std::memory_order_relaxed);
+	}
+
+	return result;
+}
+
+} // namespace ogl::jobs
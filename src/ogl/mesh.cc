@@ -5,6 +5,8 @@
 
 #include <glm/ext.hpp>
 
+#include <e3d/ogl/state.hh>
+
 
 
 namespace ogl
@@ -38,6 +40,14 @@ size(
 	return size_;
 }
 
+auto Mesh::
+vertices(
+	) const
+	-> std::vector<obj::Vertex> const&
+{
+	return obj_.vertices;
+}
+
 
 
 // Buffers
@@ -92,6 +102,15 @@ calculate_bounds(
 				maximum[i] = v.position[i];
 }
 
+auto Mesh::
+bounds(
+	) const
+	-> Aabb
+{
+	// Local bounds in world space
+	return transform(Aabb{ minimum, maximum }, model_matrix());
+}
+
 auto Mesh::
 reset_transforms(
 	)
@@ -100,6 +119,7 @@ reset_transforms(
 	scale       = glm::vec3(1.0F);
 	position    = glm::vec3(0.0F);
 	orientation = glm::quat();
+	previous_   = current_transform();
 }
 
 auto Mesh::
@@ -135,6 +155,34 @@ rotate(
 	orientation = glm::normalize(orientation * q);
 }
 
+auto Mesh::
+current_transform(
+	) const
+	-> Transform
+{
+	auto result        = Transform();
+	result.position    = position;
+	result.orientation = orientation;
+	result.scale       = scale;
+	return result;
+}
+
+auto Mesh::
+previous_transform(
+	) const
+	-> Transform const&
+{
+	return previous_;
+}
+
+auto Mesh::
+save_transform(
+	)
+	-> void
+{
+	previous_ = current_transform();
+}
+
 
 
 // Matrices
@@ -167,10 +215,7 @@ model_matrix(
 	) const
 	-> glm::mat4
 {
-	return
-		translate_matrix()
-		* rotate_matrix()
-		* scale_matrix();
+	return current_transform().matrix();
 }
 
 auto Mesh::
@@ -178,9 +223,25 @@ normal_matrix(
 	) const
 	-> glm::mat3
 {
-	return glm::transpose(glm::inverse(
-		glm::mat3(rotate_matrix())
-		* glm::mat3(scale_matrix())));
+	return current_transform().normal_matrix();
+}
+
+auto Mesh::
+model_matrix(
+	float const alpha
+	) const
+	-> glm::mat4
+{
+	return interpolate(previous_, current_transform(), alpha).matrix();
+}
+
+auto Mesh::
+normal_matrix(
+	float const alpha
+	) const
+	-> glm::mat3
+{
+	return interpolate(previous_, current_transform(), alpha).normal_matrix();
 }
 
 
@@ -473,11 +534,11 @@ initialise_mesh(
 
 	// Create vertex array object
 	glGenVertexArrays(1, &vao_);
-	glBindVertexArray(vao_);
+	state::bind_vertex_array(vao_);
 
 	// Create vertex buffer, bind to location 0
 	glGenBuffers(1, &vbo_);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+	state::bind_buffer(GL_ARRAY_BUFFER, vbo_);
 	glBufferData(
 		GL_ARRAY_BUFFER,
 		size_ * sizeof(vertices.front()),
@@ -488,7 +549,7 @@ initialise_mesh(
 
 	// Create normal buffer, bind to location 1
 	glGenBuffers(1, &nbo_);
-	glBindBuffer(GL_ARRAY_BUFFER, nbo_);
+	state::bind_buffer(GL_ARRAY_BUFFER, nbo_);
 	glBufferData(
 		GL_ARRAY_BUFFER,
 		size_ * sizeof(normals.front()),
@@ -504,7 +565,7 @@ initialise_mesh(
 
 	// Create uv buffer, bind to location 2
 	glGenBuffers(1, &ubo_);
-	glBindBuffer(GL_ARRAY_BUFFER, ubo_);
+	state::bind_buffer(GL_ARRAY_BUFFER, ubo_);
 	glBufferData(
 		GL_ARRAY_BUFFER,
 		size_ * sizeof(uvs.front()),
@@ -513,7 +574,7 @@ initialise_mesh(
 	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
 
-	glBindVertexArray(0);
+	state::bind_vertex_array(0);
 }
 
 
@@ -524,6 +585,11 @@ clean(
 	)
 	-> void
 {
+	state::release_vertex_array(vao_);
+	state::release_buffer(vbo_);
+	state::release_buffer(nbo_);
+	state::release_buffer(ubo_);
+
 	if (vao_)
 		glDeleteVertexArrays(1, &vao_);
 	if (vbo_)
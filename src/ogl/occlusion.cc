@@ -0,0 +1,404 @@
+#include <e3d/ogl/occlusion.hh>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include <e3d/ogl/jobs.hh>
+#include <e3d/ogl/profiler.hh>
+
+
+
+namespace ogl
+{
+
+// Points closer than this in clip w are cut away before rasterising
+auto static constexpr near_w_ = 1e-4F;
+
+// Boxes are hidden only when this much further away (relative, in w) than
+// the occluders, so an occluder's own bounds never cull it through rounding
+auto static constexpr depth_bias_ = 1.001F;
+
+auto static
+elapsed(
+	profiler::clock::time_point const start
+	)
+	-> double
+{
+	return std::chrono::duration<double, std::milli>(profiler::clock::now() - start).count();
+}
+
+// Twice the signed area of a, b, p
+auto static
+edge(
+	glm::vec2 const& a,
+	glm::vec2 const& b,
+	glm::vec2 const& p
+	)
+	-> float
+{
+	return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
+
+
+
+// Statistics
+auto OcclusionBuffer::Stats::
+cost(
+	) const
+	-> double
+{
+	return rasterise + build + test;
+}
+
+
+
+// Constructors
+OcclusionBuffer::
+OcclusionBuffer(
+	std::size_t const width,
+	std::size_t const height
+	)
+{
+	auto level   = Level();
+	level.width  = std::max(width, std::size_t(1U));
+	level.height = std::max(height, std::size_t(1U));
+
+	// Halve (rounding up) down to a single texel
+	while (true)
+	{
+		level.depth.assign(level.width * level.height, 0.0F);
+		levels_.push_back(level);
+		if (level.width == 1U && level.height == 1U)
+			break;
+
+		level.width  = (level.width + 1U) / 2U;
+		level.height = (level.height + 1U) / 2U;
+	}
+}
+
+
+
+// Occluders
+auto OcclusionBuffer::
+begin(
+	glm::mat4 const& view_projection
+	)
+	-> void
+{
+	view_projection_ = view_projection;
+	stats_           = Stats();
+
+	// Nothing drawn is infinitely far
+	std::fill(levels_.front().depth.begin(), levels_.front().depth.end(), 0.0F);
+}
+
+auto OcclusionBuffer::
+add(
+	Mesh const& mesh
+	)
+	-> void
+{
+	add(mesh.vertices(), mesh.model_matrix());
+}
+
+auto OcclusionBuffer::
+add(
+	std::vector<obj::Vertex> const& vertices,
+	glm::mat4                const& model
+	)
+	-> void
+{
+	auto const start  = profiler::clock::now();
+	auto const matrix = view_projection_ * model;
+
+	for (auto i = std::size_t(0U); i + 2U < vertices.size(); i += 3U)
+		rasterise(
+			matrix * glm::vec4(vertices[i].position, 1.0F),
+			matrix * glm::vec4(vertices[i + 1U].position, 1.0F),
+			matrix * glm::vec4(vertices[i + 2U].position, 1.0F));
+
+	++stats_.occluders;
+	stats_.triangles += vertices.size() / 3U;
+	stats_.rasterise += elapsed(start);
+}
+
+auto OcclusionBuffer::
+build(
+	)
+	-> void
+{
+	auto const scope = profiler::Scope("occlusion build");
+	auto const start = profiler::clock::now();
+
+	// Keep the furthest of the (up to) four texels beneath, edges of odd
+	// sized levels repeat their last row or column
+	for (auto l = std::size_t(1U); l < levels_.size(); ++l)
+	{
+		auto const& source = levels_[l - 1U];
+		auto&       level  = levels_[l];
+
+		for (auto y = std::size_t(0U); y < level.height; ++y)
+		{
+			auto const y0 = std::min(2U * y, source.height - 1U);
+			auto const y1 = std::min(2U * y + 1U, source.height - 1U);
+			for (auto x = std::size_t(0U); x < level.width; ++x)
+			{
+				auto const x0 = std::min(2U * x, source.width - 1U);
+				auto const x1 = std::min(2U * x + 1U, source.width - 1U);
+				level.depth[y * level.width + x] = std::min(
+					std::min(source.depth[y0 * source.width + x0], source.depth[y0 * source.width + x1]),
+					std::min(source.depth[y1 * source.width + x0], source.depth[y1 * source.width + x1]));
+			}
+		}
+	}
+
+	stats_.build += elapsed(start);
+}
+
+
+
+// Tests
+auto OcclusionBuffer::
+visible(
+	Aabb const& box
+	)
+	-> bool
+{
+	auto const start  = profiler::clock::now();
+	auto const hidden = occluded(box);
+
+	++stats_.tested;
+	if (hidden)
+		++stats_.culled;
+	stats_.test += elapsed(start);
+
+	return !hidden;
+}
+
+auto OcclusionBuffer::
+test(
+	std::vector<Aabb>         const& boxes,
+	std::vector<std::uint8_t>&       inside
+	)
+	-> void
+{
+	auto const scope = profiler::Scope("occlusion test");
+	auto const start = profiler::clock::now();
+
+	auto const count = std::min(boxes.size(), inside.size());
+	auto const before = std::size_t(std::count(inside.begin(), inside.begin() + count, 1U));
+
+	jobs::parallel_for(0U, count, 256U,
+		[this, &boxes, &inside](std::size_t const begin, std::size_t const end)
+		{
+			for (auto i = begin; i < end; ++i)
+				if (inside[i] && occluded(boxes[i]))
+					inside[i] = 0U;
+		});
+
+	auto const after = std::size_t(std::count(inside.begin(), inside.begin() + count, 1U));
+
+	stats_.tested += before;
+	stats_.culled += before - after;
+	stats_.test   += elapsed(start);
+}
+
+
+
+// Details
+auto OcclusionBuffer::
+width(
+	) const
+	-> std::size_t
+{
+	return levels_.front().width;
+}
+
+auto OcclusionBuffer::
+height(
+	) const
+	-> std::size_t
+{
+	return levels_.front().height;
+}
+
+auto OcclusionBuffer::
+depth(
+	) const
+	-> std::vector<float> const&
+{
+	return levels_.front().depth;
+}
+
+auto OcclusionBuffer::
+stats(
+	) const
+	-> Stats const&
+{
+	return stats_;
+}
+
+
+
+// Internal
+auto OcclusionBuffer::
+occluded(
+	Aabb const& box
+	) const
+	-> bool
+{
+	if (!box.is_valid())
+		return false;
+
+	// Screen rectangle and nearest depth of the corners, w is linear across
+	// the box so its nearest point is one of them
+	auto minimum = glm::vec2( std::numeric_limits<float>::max());
+	auto maximum = glm::vec2(-std::numeric_limits<float>::max());
+	auto nearest = 0.0F;
+	for (auto i = 0; i < 8; ++i)
+	{
+		auto const corner = glm::vec3(
+			i & 1 ? box.maximum.x : box.minimum.x,
+			i & 2 ? box.maximum.y : box.minimum.y,
+			i & 4 ? box.maximum.z : box.minimum.z);
+
+		// Crossing the near plane could hide anything
+		auto const clip = view_projection_ * glm::vec4(corner, 1.0F);
+		if (clip.w <= near_w_)
+			return false;
+
+		auto const ndc = glm::vec2(clip) / clip.w;
+		minimum = glm::min(minimum, ndc);
+		maximum = glm::max(maximum, ndc);
+		nearest = std::max(nearest, 1.0F / clip.w);
+	}
+
+	// Off screen is for the frustum to decide
+	if (maximum.x < -1.0F || maximum.y < -1.0F || minimum.x > 1.0F || minimum.y > 1.0F)
+		return false;
+
+	auto const& base  = levels_.front();
+	auto const  texel = [](float const ndc, std::size_t const size)
+	{
+		auto const t = std::floor((ndc * 0.5F + 0.5F) * float(size));
+		return std::size_t(std::clamp(t, 0.0F, float(size - 1U)));
+	};
+
+	auto x0 = texel(minimum.x, base.width);
+	auto x1 = texel(maximum.x, base.width);
+	auto y0 = texel(minimum.y, base.height);
+	auto y1 = texel(maximum.y, base.height);
+
+	// Climb until the rectangle spans at most two texels each way
+	auto l = std::size_t(0U);
+	while (l + 1U < levels_.size() && (x1 - x0 > 1U || y1 - y0 > 1U))
+	{
+		x0 /= 2U;
+		x1 /= 2U;
+		y0 /= 2U;
+		y1 /= 2U;
+		++l;
+	}
+
+	// Hidden only when behind the furthest occluder in every covering texel
+	auto const& level = levels_[l];
+	for (auto y = y0; y <= y1; ++y)
+		for (auto x = x0; x <= x1; ++x)
+			if (nearest * depth_bias_ >= level.depth[y * level.width + x])
+				return false;
+
+	return true;
+}
+
+auto OcclusionBuffer::
+rasterise(
+	glm::vec4 const& a,
+	glm::vec4 const& b,
+	glm::vec4 const& c
+	)
+	-> void
+{
+	// Cut against the near plane, a triangle becomes at most a quad
+	auto const input   = std::array<glm::vec4, 3>{ a, b, c };
+	auto       polygon = std::array<glm::vec4, 4>();
+	auto       count   = std::size_t(0U);
+	for (auto i = std::size_t(0U); i < 3U; ++i)
+	{
+		auto const& p = input[i];
+		auto const& q = input[(i + 1U) % 3U];
+		if (p.w >= near_w_)
+			polygon[count++] = p;
+		if ((p.w >= near_w_) != (q.w >= near_w_))
+			polygon[count++] = glm::mix(p, q, (near_w_ - p.w) / (q.w - p.w));
+	}
+
+	if (count < 3U)
+		return;
+
+	// Screen positions, and one over w which is linear across the screen
+	auto& level  = levels_.front();
+	auto  screen = std::array<glm::vec2, 4>();
+	auto  depth  = std::array<float, 4>();
+	for (auto i = std::size_t(0U); i < count; ++i)
+	{
+		auto const& p = polygon[i];
+		screen[i] = glm::vec2(
+			(p.x / p.w * 0.5F + 0.5F) * float(level.width),
+			(p.y / p.w * 0.5F + 0.5F) * float(level.height));
+		depth[i]  = 1.0F / p.w;
+	}
+
+	// Fan out, filling only texels entirely inside (either winding) with the
+	// furthest depth over them, so no texel claims more than is really drawn.
+	// Edges shared inside a mesh leave a line of texels neither side fills
+	for (auto i = std::size_t(1U); i + 1U < count; ++i)
+	{
+		auto const& v0 = screen[0];
+		auto const& v1 = screen[i];
+		auto const& v2 = screen[i + 1U];
+
+		auto const area = edge(v0, v1, v2);
+		if (std::abs(area) < 1e-8F)
+			continue;
+
+		auto const lower = glm::max(glm::floor(glm::min(v0, glm::min(v1, v2))), glm::vec2(0.0F));
+		auto const upper = glm::min(glm::ceil(glm::max(v0, glm::max(v1, v2))),
+			glm::vec2(float(level.width), float(level.height)));
+		if (lower.x >= upper.x || lower.y >= upper.y)
+			continue;
+
+		// Edge values step by constants along a row and up a column,
+		// normalised so inside is positive and the three sum to one. Being
+		// linear, their smallest over a texel is at the corner the steps point
+		// away from, which is found once
+		auto const scale    = 1.0F / area;
+		auto const step     = glm::vec3(v2.y - v1.y, v0.y - v2.y, v1.y - v0.y) * -scale;
+		auto const up       = glm::vec3(v2.x - v1.x, v0.x - v2.x, v1.x - v0.x) * scale;
+		auto const z        = glm::vec3(depth[0], depth[i], depth[i + 1U]);
+		auto const corner   = glm::min(step, glm::vec3(0.0F)) + glm::min(up, glm::vec3(0.0F));
+		auto const furthest = std::min(glm::dot(step, z), 0.0F) + std::min(glm::dot(up, z), 0.0F);
+
+		for (auto y = std::size_t(lower.y); y < std::size_t(upper.y); ++y)
+		{
+			// Weights at the lowest corner of each texel, moved to its worst
+			auto const origin = glm::vec2(lower.x, float(y));
+			auto weights = glm::vec3(
+				edge(v1, v2, origin),
+				edge(v2, v0, origin),
+				edge(v0, v1, origin)) * scale + corner;
+
+			auto* row = &level.depth[y * level.width];
+			for (auto x = std::size_t(lower.x); x < std::size_t(upper.x); ++x)
+			{
+				if (weights.x >= 0.0F && weights.y >= 0.0F && weights.z >= 0.0F)
+					row[x] = std::max(row[x], glm::dot(weights - corner, z) + furthest);
+				weights += step;
+			}
+		}
+	}
+}
+
+} // namespace ogl
@@ -0,0 +1,371 @@
+#include <e3d/ogl/profiler.hh>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+
+
+namespace ogl::profiler
+{
+
+// Details
+bool        enabled = true;
+std::size_t history = 600U;
+
+// In flight GPU query
+struct Query
+{
+	GLuint           id    = 0U;
+	std::string_view name;
+	double           start = 0.0;
+	std::uint64_t    frame = 0U;
+};
+
+// Timeline
+auto static const epoch_   = clock::now();
+auto static       started_ = false;
+auto static       current_ = Frame();
+auto static       frames_  = std::deque<Frame>();
+auto static       open_    = std::vector<std::size_t>();
+
+// GPU queries are recycled through a pool and read back without waiting
+auto static pending_   = std::deque<Query>();
+auto static pool_      = std::vector<GLuint>();
+auto static gpu_depth_ = 0U;
+auto static gpu_query_ = Query();
+
+
+
+// Milliseconds since the profiler started
+auto static
+now(
+	)
+	-> double
+{
+	return std::chrono::duration<double, std::milli>(clock::now() - epoch_).count();
+}
+
+// Read back finished queries, stopping at the first unfinished one
+auto static
+resolve(
+	)
+	-> void
+{
+	while (!pending_.empty())
+	{
+		auto const query     = pending_.front();
+		auto       available = GLint{};
+		glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+
+		auto elapsed = GLuint64{};
+		glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &elapsed);
+		pending_.pop_front();
+		pool_.push_back(query.id);
+
+		// Attach to the frame if it is still in the history
+		auto const frame = std::find_if(frames_.rbegin(), frames_.rend(),
+			[&query](Frame const& f) { return f.index == query.frame; });
+
+		if (frame != frames_.rend())
+			frame->samples.push_back(Sample{
+				query.name,
+				Track::Gpu,
+				0U,
+				query.start,
+				double(elapsed) / 1.0e6 });
+	}
+}
+
+// Nearest rank percentiles of a list of durations
+auto static
+summarise(
+	std::vector<double>& durations
+	)
+	-> Stats
+{
+	auto result = Stats();
+	if (durations.empty())
+		return result;
+
+	std::sort(durations.begin(), durations.end());
+
+	auto const rank = [&durations](double const p)
+	{
+		auto const i = std::size_t(p * double(durations.size() - 1U) + 0.5);
+		return durations[std::min(i, durations.size() - 1U)];
+	};
+
+	auto total = 0.0;
+	for (auto const d : durations)
+		total += d;
+
+	result.average = total / double(durations.size());
+	result.p50     = rank(0.50);
+	result.p99     = rank(0.99);
+	result.maximum = durations.back();
+	result.count   = durations.size();
+	return result;
+}
+
+// Minimal escaping for JSON strings
+auto static
+escape(
+	std::string_view const text
+	)
+	-> std::string
+{
+	auto result = std::string();
+	result.reserve(text.size());
+	for (auto const c : text)
+	{
+		if (c == '"' || c == '\\')
+			result += '\\';
+		result += c;
+	}
+	return result;
+}
+
+
+
+// Frames
+auto
+new_frame(
+	)
+	-> void
+{
+	if (!enabled)
+		return;
+
+	auto const time = now();
+
+	// Close the current frame
+	if (started_)
+	{
+		current_.duration = time - current_.start;
+		frames_.push_back(std::move(current_));
+		while (frames_.size() > history)
+			frames_.pop_front();
+	}
+
+	resolve();
+
+	// Begin the next one
+	auto const index = current_.index + 1U;
+	current_         = Frame();
+	current_.index   = index;
+	current_.start   = time;
+	started_         = true;
+	open_.clear();
+}
+
+auto
+frames(
+	)
+	-> std::deque<Frame> const&
+{
+	return frames_;
+}
+
+
+
+// CPU timing
+auto
+begin(
+	std::string_view const name
+	)
+	-> void
+{
+	if (!enabled || !started_)
+		return;
+
+	open_.push_back(current_.samples.size());
+	current_.samples.push_back(Sample{
+		name,
+		Track::Cpu,
+		std::uint32_t(open_.size() - 1U),
+		now(),
+		0.0 });
+}
+
+auto
+end(
+	)
+	-> void
+{
+	if (!enabled || open_.empty())
+		return;
+
+	auto& sample    = current_.samples[open_.back()];
+	sample.duration = now() - sample.start;
+	open_.pop_back();
+}
+
+
+
+// GPU timing
+auto
+begin_gpu(
+	std::string_view const name
+	)
+	-> void
+{
+	if (!enabled || !started_)
+		return;
+
+	// Only the outermost region is timed
+	if (gpu_depth_++ > 0U)
+	{
+		auto static warned = false;
+		if (!warned)
+			std::cerr << "WARNING: Nested GPU profiler region " <<
+				name << " is not timed" << std::endl;
+		warned = true;
+		return;
+	}
+
+	if (pool_.empty())
+	{
+		pool_.emplace_back();
+		glGenQueries(1, &pool_.back());
+	}
+
+	gpu_query_ = Query{ pool_.back(), name, now(), current_.index };
+	pool_.pop_back();
+
+	glBeginQuery(GL_TIME_ELAPSED, gpu_query_.id);
+}
+
+auto
+end_gpu(
+	)
+	-> void
+{
+	if (gpu_depth_ == 0U || --gpu_depth_ > 0U)
+		return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	pending_.push_back(gpu_query_);
+}
+
+
+
+// Statistics
+auto
+frame_time(
+	)
+	-> Stats
+{
+	auto durations = std::vector<double>();
+	durations.reserve(frames_.size());
+	for (auto const& f : frames_)
+		durations.push_back(f.duration);
+
+	return summarise(durations);
+}
+
+auto
+stats(
+	std::string_view const name,
+	Track            const track
+	)
+	-> Stats
+{
+	// Regions entered several times in a frame count once, summed
+	auto durations = std::vector<double>();
+	durations.reserve(frames_.size());
+	for (auto const& f : frames_)
+	{
+		auto total = 0.0;
+		auto found = false;
+		for (auto const& s : f.samples)
+		{
+			if (s.track == track && s.name == name)
+			{
+				total += s.duration;
+				found  = true;
+			}
+		}
+
+		if (found)
+			durations.push_back(total);
+	}
+
+	return summarise(durations);
+}
+
+
+
+// Output
+auto
+write_trace(
+	std::string_view const filename
+	)
+	-> bool
+{
+	auto file = std::ofstream(std::string(filename));
+	if (!file)
+	{
+		std::cerr << "ERROR: Could not write trace " <<
+			filename << std::endl;
+		return false;
+	}
+
+	// Complete events use microseconds, CPU and GPU on separate threads
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+	file.precision(3);
+	file << std::fixed;
+	for (auto const& f : frames_)
+	{
+		file << ",\n{\"name\":\"frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1" <<
+			",\"ts\":" << f.start * 1000.0 <<
+			",\"dur\":" << f.duration * 1000.0 <<
+			",\"args\":{\"index\":" << f.index << "}}";
+
+		file << ",\n{\"name\":\"frame time\",\"ph\":\"C\",\"pid\":1" <<
+			",\"ts\":" << f.start * 1000.0 <<
+			",\"args\":{\"ms\":" << f.duration << "}}";
+
+		for (auto const& s : f.samples)
+		{
+			auto const gpu = s.track == Track::Gpu;
+			file << ",\n{\"name\":\"" << escape(s.name) <<
+				"\",\"cat\":\"" << (gpu ? "gpu" : "cpu") <<
+				"\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (gpu ? 2 : 1) <<
+				",\"ts\":" << s.start * 1000.0 <<
+				",\"dur\":" << s.duration * 1000.0 << "}";
+		}
+	}
+
+	file << "\n]}\n";
+	return bool(file);
+}
+
+auto
+shutdown(
+	)
+	-> void
+{
+	if (gpu_depth_ > 0U)
+		glEndQuery(GL_TIME_ELAPSED);
+	gpu_depth_ = 0U;
+
+	for (auto const& q : pending_)
+		pool_.push_back(q.id);
+	pending_.clear();
+
+	if (!pool_.empty())
+		glDeleteQueries(GLsizei(pool_.size()), pool_.data());
+	pool_.clear();
+}
+
+} // namespace ogl::profiler
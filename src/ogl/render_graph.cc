@@ -0,0 +1,345 @@
+#include <e3d/ogl/render_graph.hh>
+
+#include <algorithm>
+#include <iostream>
+
+#include <e3d/ogl/profiler.hh>
+#include <e3d/ogl/renderer.hh>
+#include <e3d/ogl/state.hh>
+
+
+
+namespace ogl
+{
+
+// Builder
+RenderGraph::Builder::
+Builder(
+	RenderGraph&      graph,
+	std::size_t const pass
+	) :
+	graph_(graph),
+	pass_(pass)
+{}
+
+auto RenderGraph::Builder::
+read(
+	Resource const resource,
+	GLuint   const unit,
+	bool     const depth
+	)
+	-> void
+{
+	graph_.passes_[pass_].reads.push_back(Read{ resource, unit, depth });
+}
+
+auto RenderGraph::Builder::
+write(
+	Resource const resource,
+	bool     const clear
+	)
+	-> void
+{
+	auto& pass = graph_.passes_[pass_];
+	if (pass.target.has_value())
+		std::cerr << "ERROR: Pass " <<
+			pass.name << " writes more than one target, keeping " <<
+			graph_.nodes_[resource].name << std::endl;
+
+	pass.target = resource;
+	pass.clear  = clear;
+}
+
+auto RenderGraph::Builder::
+side_effect(
+	)
+	-> void
+{
+	graph_.passes_[pass_].side_effect = true;
+}
+
+
+
+// Constructors
+RenderGraph::
+RenderGraph(
+	FramebufferPool& pool
+	) :
+	pool_(pool)
+{}
+
+
+
+// Resources
+auto RenderGraph::
+create(
+	std::string_view               const name,
+	Framebuffer::Descriptor const&       descriptor
+	)
+	-> Resource
+{
+	auto node       = Node();
+	node.name       = name;
+	node.descriptor = descriptor;
+	nodes_.push_back(node);
+
+	compiled_ = false;
+	return nodes_.size() - 1U;
+}
+
+auto RenderGraph::
+import(
+	std::string_view   const name,
+	Framebuffer const* const framebuffer
+	)
+	-> Resource
+{
+	auto node        = Node();
+	node.name        = name;
+	node.imported    = true;
+	node.framebuffer = framebuffer;
+	if (framebuffer)
+		node.descriptor = framebuffer->descriptor();
+	nodes_.push_back(node);
+
+	compiled_ = false;
+	return nodes_.size() - 1U;
+}
+
+auto RenderGraph::
+get(
+	Resource const resource
+	) const
+	-> Framebuffer const*
+{
+	return nodes_[resource].framebuffer;
+}
+
+
+
+// Passes
+auto RenderGraph::
+add_pass(
+	std::string_view const name,
+	setup_function   const setup,
+	execute_function       execute
+	)
+	-> void
+{
+	auto pass    = Pass();
+	pass.name    = name;
+	pass.execute = std::move(execute);
+	passes_.push_back(std::move(pass));
+
+	auto builder = Builder(*this, passes_.size() - 1U);
+	setup(builder);
+
+	compiled_ = false;
+}
+
+auto RenderGraph::
+compile(
+	)
+	-> void
+{
+	auto const start = profiler::clock::now();
+
+	// Walk back from the imported targets, a pass lives if something needs
+	// what it writes. Passes run in declaration order, which already puts
+	// every writer before its readers
+	auto needed = std::vector<bool>(nodes_.size());
+	for (auto i = std::size_t(0U); i < nodes_.size(); ++i)
+		needed[i] = nodes_[i].imported;
+
+	for (auto it = passes_.rbegin(); it != passes_.rend(); ++it)
+	{
+		it->culled = !it->side_effect && !(it->target && needed[*it->target]);
+		if (!it->culled)
+			for (auto const& r : it->reads)
+				needed[r.resource] = true;
+	}
+
+	// Lifetimes in execution order
+	for (auto& node : nodes_)
+		node.used = false;
+
+	auto const touch = [this](Resource const resource, std::size_t const index)
+	{
+		auto& node = nodes_[resource];
+		if (!node.used)
+			node.first = index;
+		node.last = index;
+		node.used = true;
+	};
+
+	auto written = std::vector<bool>(nodes_.size());
+	auto index   = std::size_t(0U);
+	stats_       = Stats();
+	for (auto& pass : passes_)
+	{
+		if (pass.culled)
+		{
+			++stats_.culled;
+			continue;
+		}
+
+		// Only colour is resolved, multisampled depth cannot be sampled as a
+		// plain texture, so those reads are dropped
+		pass.reads.erase(
+			std::remove_if(pass.reads.begin(), pass.reads.end(), [this, &pass](Read const& r)
+			{
+				auto const& node = nodes_[r.resource];
+				if (!r.depth || node.descriptor.samples <= 1U)
+					return false;
+
+				std::cerr << "ERROR: Pass " <<
+					pass.name << " reads the depth of multisampled " <<
+					node.name << ", which is never resolved" << std::endl;
+				return true;
+			}),
+			pass.reads.end());
+
+		for (auto const& r : pass.reads)
+		{
+			auto const& node = nodes_[r.resource];
+			if (r.resource == pass.target)
+				std::cerr << "ERROR: Pass " <<
+					pass.name << " reads and writes " <<
+					node.name << std::endl;
+			else if (node.imported ? !node.framebuffer : !written[r.resource])
+				std::cerr << "ERROR: Pass " <<
+					pass.name << " reads " <<
+					node.name << " before anything writes it" << std::endl;
+
+			touch(r.resource, index);
+		}
+
+		if (pass.target)
+		{
+			written[*pass.target] = true;
+			touch(*pass.target, index);
+		}
+
+		++index;
+	}
+
+	stats_.passes  = index;
+	stats_.compile = std::chrono::duration<double, std::milli>(
+		profiler::clock::now() - start).count();
+	compiled_ = true;
+}
+
+auto RenderGraph::
+execute(
+	)
+	-> void
+{
+	if (!compiled_)
+		compile();
+
+	auto const start = profiler::clock::now();
+	auto const scope = profiler::Scope("render graph");
+
+	stats_.bytes           = 0U;
+	stats_.unaliased_bytes = 0U;
+
+	auto written  = std::vector<bool>(nodes_.size());
+	auto resolved = std::vector<bool>(nodes_.size());
+	auto distinct = std::vector<Framebuffer const*>();
+	auto index    = std::size_t(0U);
+	for (auto const& pass : passes_)
+	{
+		if (pass.culled)
+			continue;
+
+		// Transient targets come from the pool for their lifetime only, so
+		// targets that never overlap share memory
+		for (auto& node : nodes_)
+		{
+			if (node.imported || !node.used || node.first != index)
+				continue;
+
+			node.framebuffer = &pool_.acquire(node.descriptor);
+			stats_.unaliased_bytes += node.framebuffer->size_bytes();
+			if (std::find(distinct.begin(), distinct.end(), node.framebuffer) == distinct.end())
+			{
+				distinct.push_back(node.framebuffer);
+				stats_.bytes += node.framebuffer->size_bytes();
+			}
+		}
+
+		auto const pass_scope = profiler::Scope(pass.name);
+
+		if (pass.target)
+		{
+			auto const framebuffer = nodes_[*pass.target].framebuffer;
+			auto const resolution  = renderer::resolution();
+			renderer::target(framebuffer);
+			state::viewport(
+				0,
+				0,
+				framebuffer ? GLsizei(framebuffer->width())  : GLsizei(resolution.x),
+				framebuffer ? GLsizei(framebuffer->height()) : GLsizei(resolution.y));
+
+			// Only the first write of a frame starts from nothing
+			if (pass.clear && !written[*pass.target])
+				renderer::clear();
+			written[*pass.target]  = true;
+			resolved[*pass.target] = false;
+		}
+
+		for (auto const& r : pass.reads)
+		{
+			auto const framebuffer = nodes_[r.resource].framebuffer;
+			if (!framebuffer)
+				continue;
+
+			if (!resolved[r.resource] && !r.depth)
+			{
+				framebuffer->resolve();
+				resolved[r.resource] = true;
+			}
+
+			renderer::bind(r.depth ? framebuffer->depth() : framebuffer->frame(), r.unit);
+		}
+
+		pass.execute(*this);
+
+		// Hand back targets nothing later reads
+		for (auto& node : nodes_)
+			if (!node.imported && node.used && node.last == index)
+			{
+				pool_.release(*node.framebuffer);
+				node.framebuffer = nullptr;
+			}
+
+		++index;
+	}
+
+	stats_.framebuffers = distinct.size();
+	stats_.execute      = std::chrono::duration<double, std::milli>(
+		profiler::clock::now() - start).count();
+}
+
+auto RenderGraph::
+reset(
+	)
+	-> void
+{
+	passes_.clear();
+	nodes_.clear();
+	compiled_ = false;
+}
+
+
+
+// Statistics
+auto RenderGraph::
+stats(
+	) const
+	-> Stats const&
+{
+	return stats_;
+}
+
+} // namespace ogl
@@ -1,7 +1,19 @@
 #include <e3d/ogl/renderer.hh>
 
+#include <memory>
 #include <sstream>
 
+#ifdef ENGIN3D_EGL
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <e3d/ogl/input.hh>
+#include <e3d/ogl/profiler.hh>
+#include <e3d/ogl/state.hh>
+
 
 
 namespace ogl::renderer
@@ -11,13 +23,31 @@ namespace ogl::renderer
 std::string    title  = "Engin3D";
 std::uintmax_t width  = 1280U;
 std::uintmax_t height = 720U;
+bool           headless = false;
 
 // Camera
 Camera camera;
 
+// Render targets
+FramebufferPool                     framebuffers;
+std::function<void(GLuint, GLuint)> resize_function = [](GLuint, GLuint){};
+
 // Window handle
 GLFWwindow static* window_ = nullptr;
 
+// Headless context and the framebuffer standing in for the window
+auto static running_   = false;
+auto static offscreen_ = std::unique_ptr<Framebuffer>();
+
+#ifdef ENGIN3D_EGL
+auto static egl_display_ = EGLDisplay(EGL_NO_DISPLAY);
+auto static egl_context_ = EGLContext(EGL_NO_CONTEXT);
+auto static egl_surface_ = EGLSurface(EGL_NO_SURFACE);
+#endif
+
+// Bound render target
+auto static target_ = GLuint(0U);
+
 // Dimensions
 auto static screen_width_  = 0;
 auto static screen_height_ = 0;
@@ -27,6 +57,13 @@ auto static first_mouse_ = true;
 auto static mouse_pos_   = glm::vec2();
 auto static keyboard_    = keyboard_t{ false };
 
+// Mouse input not yet applied to the camera, zoom in scroll steps
+auto static aim_  = glm::vec2(0.0F);
+auto static zoom_ = 0;
+
+// Depth convention, applied to the context once it exists
+auto static reverse_z_ = false;
+
 
 
 // Callback functions
@@ -40,9 +77,16 @@ key_callback(
 	)
 	-> void
 {
-	// Set key state
+	// Set key state, ticks see it through the event queue
 	if (key != GLFW_KEY_UNKNOWN)
 	{
+		auto event   = input::Event();
+		event.type   = input::Type::Key;
+		event.key    = key;
+		event.action = action;
+		event.time   = clock::now();
+		input::push(event);
+
 		if (action == GLFW_PRESS)
 		{
 			keyboard_[std::size_t(key)] = true;
@@ -65,7 +109,13 @@ scroll_callback(
 	)
 	-> void
 {
-	camera.zoom(float(y_offset));
+	auto event   = input::Event();
+	event.type   = input::Type::Scroll;
+	event.offset = glm::vec2(x_offset, y_offset);
+	event.time   = clock::now();
+	input::push(event);
+
+	zoom_ += y_offset > 0.0 ? 1 : -1;
 }
 
 auto static
@@ -91,8 +141,14 @@ cursor_pos_callback(
 	// Update mouse position
 	mouse_pos_ = pos;
 
-	// Update camera
-	camera.aim(offset);
+	auto event   = input::Event();
+	event.type   = input::Type::Cursor;
+	event.offset = offset;
+	event.time   = clock::now();
+	input::push(event);
+
+	// The camera turns when the app applies it
+	aim_ += offset;
 }
 
 auto static
@@ -104,8 +160,14 @@ window_size_callback(
 	-> void
 {
 	glfwGetFramebufferSize(window, &screen_width_, &screen_height_);
-	glViewport(0, 0, screen_width_, screen_height_);
+
+	// Minimised windows have no size, keep the targets for when they return
+	if (screen_width_ == 0 || screen_height_ == 0)
+		return;
+
+	state::viewport(0, 0, screen_width_, screen_height_);
 	camera.aspect(screen_width_, screen_height_);
+	resize_function(GLuint(screen_width_), GLuint(screen_height_));
 }
 
 auto static
@@ -134,8 +196,19 @@ show_fps(
 		output.precision(3);
 		output << std::fixed << title <<
 			" - FPS: " << fps <<
-			" - Frame: " << ms_per_frame << "ms" << std::endl;
-		glfwSetWindowTitle(window_, output.str().c_str());
+			" - Frame: " << ms_per_frame << "ms";
+
+		// Stutters show up in the tail rather than the average
+		if (profiler::enabled)
+			output << " - p99: " << profiler::frame_time().p99 << "ms";
+
+		// Calls the state cache let through, and those it saved
+		auto const calls = state::counters();
+		output << " - GL: " << calls.issued << " (" << calls.skipped << " skipped)";
+
+		output << std::endl;
+		if (window_)
+			glfwSetWindowTitle(window_, output.str().c_str());
 
 		frame_count = 0;
 	}
@@ -143,6 +216,26 @@ show_fps(
 	++frame_count;
 }
 
+auto static
+apply_depth(
+	)
+	-> void
+{
+	// Zero to one clip depth needs 4.5 (or the extension), without it reversed
+	// depth still works but loses most of the precision it is there for
+	auto const clip_control = GLEW_VERSION_4_5 || GLEW_ARB_clip_control;
+	if (clip_control)
+		glClipControl(GL_LOWER_LEFT, reverse_z_ ? GL_ZERO_TO_ONE : GL_NEGATIVE_ONE_TO_ONE);
+	else if (reverse_z_)
+		std::cerr << "WARNING: No clip control, reversed depth keeps less precision" << std::endl;
+
+	state::depth_func(reverse_z_ ? GL_GREATER : GL_LESS);
+	glClearDepth(reverse_z_ ? 0.0 : 1.0);
+
+	camera.reverse_z        = reverse_z_;
+	camera.clip_zero_to_one = reverse_z_ && clip_control;
+}
+
 
 
 // Details
@@ -179,27 +272,62 @@ clear_colour(
 	glClearColor(colour.r, colour.g, colour.b, colour.a);
 }
 
+auto
+reverse_z(
+	bool const enable
+	)
+	-> void
+{
+	reverse_z_ = enable;
+	if (running_)
+		apply_depth();
+}
+
 auto
 is_running(
 	)
 	-> bool
 {
+	if (headless)
+		return running_;
+
 	return !glfwWindowShouldClose(window_);
 }
 
+auto
+stop(
+	)
+	-> void
+{
+	running_ = false;
+	if (window_)
+		glfwSetWindowShouldClose(window_, GL_TRUE);
+}
 
+auto
+offscreen(
+	)
+	-> Framebuffer const*
+{
+	return offscreen_.get();
+}
 
-// Initialise
 auto
-start(
+current_target(
 	)
-	-> void
+	-> GLuint
 {
-	// Set close function to run at exit
-	std::atexit(shutdown);
+	return target_;
+}
 
 
 
+// Context creation
+auto static
+create_window(
+	)
+	-> void
+{
 	// Initialise GLFW
 	if (!glfwInit())
 		throw std::runtime_error("ERROR: GLFW failed to initialise");
@@ -211,6 +339,10 @@ start(
 //	glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
+	// Hidden window when there is no other way to get a headless context
+	if (headless)
+		glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
 	// Window error handling
 	window_ = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
 
@@ -224,6 +356,9 @@ start(
 	glfwMakeContextCurrent(window_);
 	glfwGetFramebufferSize(window_, &screen_width_, &screen_height_);
 
+	if (headless)
+		return;
+
 	// Set callback functions
 	glfwSetKeyCallback(window_, key_callback);
 	glfwSetScrollCallback(window_, scroll_callback);
@@ -232,6 +367,113 @@ start(
 
 	// Remove mouse cursor
 	glfwSetInputMode(window_, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+}
+
+auto static
+create_headless_context(
+	)
+	-> void
+{
+#ifdef ENGIN3D_EGL
+	// Prefer a surfaceless display, which needs no window system at all
+	auto const get_platform_display =
+		reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+			eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+	if (get_platform_display)
+		egl_display_ = get_platform_display(
+			EGL_PLATFORM_SURFACELESS_MESA,
+			EGL_DEFAULT_DISPLAY,
+			nullptr);
+
+	if (egl_display_ == EGL_NO_DISPLAY)
+		egl_display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	if (egl_display_ == EGL_NO_DISPLAY
+	 || !eglInitialize(egl_display_, nullptr, nullptr))
+	{
+		shutdown();
+		throw std::runtime_error("ERROR: EGL failed to initialise");
+	}
+
+	// Desktop GL config, pbuffer capable if possible
+	EGLint config_attributes[] = {
+		EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE,        8,
+		EGL_GREEN_SIZE,      8,
+		EGL_BLUE_SIZE,       8,
+		EGL_ALPHA_SIZE,      8,
+		EGL_NONE
+	};
+
+	auto config = EGLConfig();
+	auto count  = EGLint{};
+	if (!eglChooseConfig(egl_display_, config_attributes, &config, 1, &count) || count == 0)
+	{
+		config_attributes[1] = EGL_DONT_CARE;
+		eglChooseConfig(egl_display_, config_attributes, &config, 1, &count);
+	}
+
+	if (count == 0 || !eglBindAPI(EGL_OPENGL_API))
+	{
+		shutdown();
+		throw std::runtime_error("ERROR: EGL has no desktop OpenGL config");
+	}
+
+	// Same version and profile as the window
+	EGLint const context_attributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION,       3,
+		EGL_CONTEXT_MINOR_VERSION,       3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	egl_context_ = eglCreateContext(egl_display_, config, EGL_NO_CONTEXT, context_attributes);
+	if (egl_context_ == EGL_NO_CONTEXT)
+	{
+		shutdown();
+		throw std::runtime_error("ERROR: EGL failed to create context");
+	}
+
+	// Surfaceless where supported, otherwise bind a minimal pbuffer
+	if (!eglMakeCurrent(egl_display_, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context_))
+	{
+		EGLint const pbuffer_attributes[] = {
+			EGL_WIDTH,  1,
+			EGL_HEIGHT, 1,
+			EGL_NONE
+		};
+
+		egl_surface_ = eglCreatePbufferSurface(egl_display_, config, pbuffer_attributes);
+		if (egl_surface_ == EGL_NO_SURFACE
+		 || !eglMakeCurrent(egl_display_, egl_surface_, egl_surface_, egl_context_))
+		{
+			shutdown();
+			throw std::runtime_error("ERROR: EGL failed to make context current");
+		}
+	}
+#else
+	// Without EGL an invisible window is the best available
+	create_window();
+#endif
+}
+
+
+
+// Initialise
+auto
+start(
+	)
+	-> void
+{
+	// Set close function to run at exit
+	std::atexit(shutdown);
+
+	if (headless)
+		create_headless_context();
+	else
+		create_window();
 
 
 
@@ -239,23 +481,41 @@ start(
 	glewExperimental = GL_TRUE;
 
 	// Initialise GLEW to setup the opengl function pointers
-	if (glewInit() != GLEW_OK)
+	// (without a window there is no GLX display, but GL functions still load)
+	auto const glew = glewInit();
+	if (glew != GLEW_OK && !(headless && glew == GLEW_ERROR_NO_GLX_DISPLAY))
 	{
 		shutdown();
 		throw std::runtime_error("ERROR: GLEW failed to initialise");
 	}
 
+	// Fresh context, nothing is known about its state
+	state::invalidate();
+
+	// Headless output goes to a framebuffer of the requested size
+	if (headless)
+	{
+		offscreen_     = std::make_unique<Framebuffer>(width, height);
+		screen_width_  = int(width);
+		screen_height_ = int(height);
+		target();
+	}
+
 	// Define the viewport dimensions
-	glViewport(0, 0, screen_width_, screen_height_);
+	state::viewport(0, 0, screen_width_, screen_height_);
 
 	// Set up some other opengl options
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	state::enable(GL_DEPTH_TEST);
+	state::enable(GL_BLEND);
+	state::blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	apply_depth();
 
 	camera.aspect(screen_width_, screen_height_);
 
-	std::cout << "App initialised" << std::endl;
+	running_ = true;
+
+	std::cout << "App initialised" <<
+		(headless ? " (headless)" : "") << std::endl;
 }
 
 auto
@@ -264,10 +524,34 @@ update(
 	)
 	-> void
 {
-	glfwPollEvents();
+	poll();
 	show_fps(new_time);
 }
 
+auto
+poll(
+	)
+	-> void
+{
+	if (!headless)
+		glfwPollEvents();
+}
+
+auto
+aim_camera(
+	)
+	-> void
+{
+	if (aim_ != glm::vec2(0.0F))
+		camera.aim(aim_);
+	for (; zoom_ > 0; --zoom_)
+		camera.zoom(1.0F);
+	for (; zoom_ < 0; ++zoom_)
+		camera.zoom(-1.0F);
+
+	aim_ = glm::vec2(0.0F);
+}
+
 
 
 // Render
@@ -278,8 +562,7 @@ bind(
 	)
 	-> void
 {
-	glActiveTexture(GL_TEXTURE0 + index);
-	glBindTexture(texture.type(), texture.id());
+	state::bind_texture(index, texture.type(), texture.id());
 }
 
 auto
@@ -288,11 +571,14 @@ target(
 	)
 	-> void
 {
-	glBindFramebuffer(
-		GL_FRAMEBUFFER,
-		framebuffer
-			? framebuffer->buffer()
-			: 0);
+	// The default target is the offscreen framebuffer when headless
+	target_ = framebuffer
+		? framebuffer->buffer()
+		: offscreen_
+			? offscreen_->buffer()
+			: 0U;
+
+	state::bind_framebuffer(GL_FRAMEBUFFER, target_);
 }
 
 auto
@@ -309,10 +595,9 @@ draw(
 	)
 	-> void
 {
-	glBindVertexArray(mesh.vao());
+	// Left bound, the next draw rebinds only if it differs
+	state::bind_vertex_array(mesh.vao());
 	glDrawArrays(GL_TRIANGLES, 0, mesh.size());
-
-	glBindVertexArray(0);
 }
 
 auto
@@ -320,8 +605,54 @@ display(
 	)
 	-> void
 {
-	glBindVertexArray(0);
+	// Nothing to present offscreen, just submit the frame
+	if (headless)
+	{
+		glFlush();
+		return;
+	}
+
+	profiler::begin("swap");
 	glfwSwapBuffers(window_);
+	profiler::end();
+}
+
+auto
+capture(
+	Framebuffer const* const framebuffer
+	)
+	-> Image
+{
+	auto const source = framebuffer
+		? framebuffer
+		: offscreen_.get();
+
+	auto image     = Image();
+	image.width    = source ? source->width()  : GLuint(screen_width_);
+	image.height   = source ? source->height() : GLuint(screen_height_);
+	image.channels = 4U;
+	image.pixels.resize(std::size_t(image.width) * image.height * image.channels);
+
+	// Multisampled pixels are read from the resolved copy
+	if (source)
+		source->resolve();
+
+	// Read tightly packed rows into client memory, then restore the read target
+	state::bind_buffer(GL_PIXEL_PACK_BUFFER, 0U);
+	state::bind_framebuffer(GL_READ_FRAMEBUFFER, source ? source->read_buffer() : 0U);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(
+		0,
+		0,
+		GLsizei(image.width),
+		GLsizei(image.height),
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		image.pixels.data());
+	state::bind_framebuffer(GL_READ_FRAMEBUFFER, target_);
+
+	image.flip_vertical();
+	return image;
 }
 
 
@@ -332,6 +663,27 @@ shutdown(
 	)
 	-> void
 {
+	// Framebuffers need the context, so go first
+	offscreen_.reset();
+	framebuffers.clear();
+	running_ = false;
+
+#ifdef ENGIN3D_EGL
+	if (egl_display_ != EGL_NO_DISPLAY)
+	{
+		eglMakeCurrent(egl_display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (egl_surface_ != EGL_NO_SURFACE)
+			eglDestroySurface(egl_display_, egl_surface_);
+		if (egl_context_ != EGL_NO_CONTEXT)
+			eglDestroyContext(egl_display_, egl_context_);
+		eglTerminate(egl_display_);
+
+		egl_display_ = EGL_NO_DISPLAY;
+		egl_context_ = EGL_NO_CONTEXT;
+		egl_surface_ = EGL_NO_SURFACE;
+	}
+#endif
+
 	glfwTerminate();
 	window_ = nullptr;
 }
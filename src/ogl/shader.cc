@@ -1,5 +1,11 @@
 #include <e3d/ogl/shader.hh>
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
 #include <memory>
 #include <sstream>
 #include <utility>
@@ -8,6 +14,8 @@
 
 #include <luna/files.hh>
 
+#include <e3d/ogl/state.hh>
+
 using namespace std::string_literals;
 using namespace std::string_view_literals;
 
@@ -16,6 +24,79 @@ using namespace std::string_view_literals;
 namespace ogl
 {
 
+// Details
+std::string Shader::cache_directory = "shader_cache";
+
+// 64 bit FNV-1a, continued from a previous hash
+auto static
+fnv1a(
+	std::string_view const data,
+	std::uint64_t          hash = 14695981039346656037ULL
+	)
+	-> std::uint64_t
+{
+	for (auto const c : data)
+		hash = (hash ^ std::uint8_t(c)) * 1099511628211ULL;
+	return hash;
+}
+
+
+
+// Join code parts, reading files
+auto static
+expand(
+	std::vector<std::pair<Shader::CodeType, std::string>> const& origin
+	)
+	-> std::string
+{
+	auto content = std::ostringstream{};
+	for (auto const& [type, code] : origin)
+	{
+		if (type == Shader::Source)
+			content << code;
+		else
+			content << luna::read_file(code).value_or(""s);
+		content << "\n"sv;
+	}
+
+	return content.str();
+}
+
+// Insert defines after the version directive, which must come first
+auto static
+inject(
+	std::string_view         const  source,
+	std::vector<std::string> const& defines
+	)
+	-> std::string
+{
+	auto insert = std::size_t(0U);
+	auto line   = 1U;
+
+	auto const version = source.find("#version");
+	if (version != std::string_view::npos)
+	{
+		auto const end = source.find('\n', version);
+		insert = end == std::string_view::npos ? source.size() : end + 1U;
+		for (auto i = std::size_t(0U); i < insert; ++i)
+			line += source[i] == '\n' ? 1U : 0U;
+	}
+
+	auto result = std::string(source.substr(0U, insert));
+	if (insert == source.size() && !result.empty() && result.back() != '\n')
+		result += '\n';
+
+	for (auto const& d : defines)
+		result += "#define " + d + "\n";
+
+	// Keep error line numbers matching the file
+	result += "#line " + std::to_string(line) + "\n";
+	result += source.substr(insert);
+	return result;
+}
+
+
+
 // Class management
 Shader::
 Shader(
@@ -63,18 +144,33 @@ is_active(
 	) const
 	-> bool
 {
-	auto p = GLint{};
-	glGetIntegerv(GL_CURRENT_PROGRAM, &p);
-	return is_valid() && program_ == GLuint(p);
+	return is_valid() && program_ == state::current_program();
 }
 
 auto Shader::
 uniform_location(
-	std::string_view const uniform
+	Uniform const uniform
 	) const
 	-> GLint
 {
-	return uniforms_.at(std::string(uniform));
+	if (uniform_table_.empty())
+		return -1;
+
+	// Linear probing, the table is never full
+	auto const mask = uniform_table_.size() - 1U;
+	for (auto i = std::size_t(uniform.hash) & mask; ; i = (i + 1U) & mask)
+	{
+		auto const& slot = uniform_table_[i];
+		if (slot.hash == uniform.hash && slot.name == uniform.name)
+			return slot.location;
+		if (slot.hash == 0U)
+			break;
+	}
+
+	// Not reflected under this name, e.g. an array element
+	auto const location = glGetUniformLocation(program_, std::string(uniform.name).c_str());
+	insert_uniform(uniform.hash, uniform.name, location);
+	return location;
 }
 
 
@@ -88,12 +184,10 @@ add(
 	)
 	-> void
 {
-	auto const shader = compile(shader_type, code_type == Source
-		? code
-		: luna::read_file(code).value_or(""s));
-
-	if (shader.has_value())
-		shaders_.emplace_back(shader.value());
+	// Compiling waits for build, which may not need to
+	origins_.push_back({ { code_type, std::string(code) } });
+	sources_.emplace_back(shader_type, expand(origins_.back()));
+	hash_sources();
 }
 
 auto Shader::
@@ -103,17 +197,12 @@ add(
 	)
 	-> void
 {
-	auto content = std::ostringstream{};
+	auto& origin = origins_.emplace_back();
 	for (auto const& c : code_array)
-	{
-		if (c.first == Source)
-			content << c.second;
-		else
-			content << luna::read_file(c.second).value_or(""s);
-		content << "\n"sv;
-	}
+		origin.emplace_back(c.first, std::string(c.second));
 
-	add(type, Source, content.str());
+	sources_.emplace_back(type, expand(origin));
+	hash_sources();
 }
 
 
@@ -124,7 +213,103 @@ build(
 	)
 	-> void
 {
-	program_ = link().value_or(0);
+	submit();
+	finish();
+}
+
+auto Shader::
+submit(
+	)
+	-> void
+{
+	submit(true);
+}
+
+auto Shader::
+submit(
+	bool const use_cache
+	)
+	-> void
+{
+	submitted_ = std::chrono::steady_clock::now();
+
+	key_     = use_cache ? cache_key() : 0U;
+	pending_ = use_cache ? load_binary(key_).value_or(0) : 0U;
+	cached_  = pending_ != 0;
+	caching_ = use_cache && !cached_;
+	if (cached_)
+		return;
+
+	for (auto const& [type, source] : sources_)
+		staged_.emplace_back(compile(type, source));
+
+	pending_ = link();
+}
+
+auto Shader::
+is_ready(
+	) const
+	-> bool
+{
+	if (!pending_ || !GLEW_KHR_parallel_shader_compile)
+		return true;
+
+	auto complete = GLint{};
+	glGetProgramiv(pending_, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete == GL_TRUE;
+}
+
+auto Shader::
+finish(
+	)
+	-> bool
+{
+	if (!pending_)
+		return is_valid();
+
+	if (cached_ || check(pending_))
+	{
+		// Replace the old program, uniform locations may have moved
+		for (auto const& s : shaders_)
+			glDeleteShader(s);
+		if (program_)
+		{
+			state::release_program(program_);
+			glDeleteProgram(program_);
+		}
+
+		shaders_ = std::move(staged_);
+		program_ = pending_;
+		if (caching_)
+			save_binary(key_, program_);
+		reflect();
+	}
+	else
+	{
+		// Keep the old program running
+		for (auto const& s : staged_)
+			glDeleteShader(s);
+		glDeleteProgram(pending_);
+	}
+	staged_.clear();
+	pending_ = 0;
+
+	time_ = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - submitted_).count();
+	std::cout << "Shader " <<
+		name << " built in " <<
+		time_ << "ms" <<
+		(cached_ ? " (cached)" : "") << std::endl;
+
+	return is_valid();
+}
+
+auto Shader::
+build_time(
+	) const
+	-> double
+{
+	return time_;
 }
 
 auto Shader::
@@ -132,7 +317,7 @@ use(
 	) const
 	-> void
 {
-	glUseProgram(program_);
+	state::use_program(program_);
 }
 
 auto Shader::
@@ -141,114 +326,484 @@ clean(
 	-> void
 {
 	if (is_active())
-		glUseProgram(0);
+		state::use_program(0);
 
 	for (auto const& s : shaders_)
 		glDeleteShader(s);
 	shaders_.clear();
+	sources_.clear();
+	origins_.clear();
+	source_hash_ = 0U;
+
+	variants_.clear();
+	defines_.clear();
 
 	uniforms_.clear();
+	uniform_table_.clear();
+	uniform_count_ = 0U;
+
+	for (auto const& s : staged_)
+		glDeleteShader(s);
+	staged_.clear();
+
+	if (pending_)
+		glDeleteProgram(pending_);
+	pending_ = 0;
 
+	state::release_program(program_);
 	glDeleteProgram(program_);
 	program_ = 0;
 }
 
 
 
-// Uniform caching
+// Variants
 auto Shader::
-uniform_location(
-	std::string_view const uniform
+define(
+	std::string_view const definition
+	)
+	-> define_mask
+{
+	for (auto i = std::size_t(0U); i < defines_.size(); ++i)
+		if (defines_[i] == definition)
+			return define_mask(1U) << i;
+
+	if (defines_.size() == 64U)
+	{
+		std::cerr << "ERROR: Too many defines in shader " <<
+			name << std::endl;
+		return 0U;
+	}
+
+	defines_.emplace_back(definition);
+	return define_mask(1U) << (defines_.size() - 1U);
+}
+
+auto Shader::
+variant(
+	define_mask const mask
+	)
+	-> Shader&
+{
+	if (mask == 0U)
+		return *this;
+
+	auto& variant = variants_[mask];
+	if (variant.shader && variant.source == source_hash_)
+		return *variant.shader;
+
+	// Built from older sources, rebuild in place so references stay valid
+	if (variant.shader)
+	{
+		update_variant(variant);
+		variant.shader->build();
+		return *variant.shader;
+	}
+
+	auto suffix = std::string();
+	for (auto i = std::size_t(0U); i < defines_.size(); ++i)
+	{
+		if (!(mask & (define_mask(1U) << i)))
+			continue;
+
+		variant.defines.push_back(defines_[i]);
+		suffix += (suffix.empty() ? "" : ",") + defines_[i].substr(0U, defines_[i].find(' '));
+	}
+
+	variant.shader = std::make_unique<Shader>(name + "[" + suffix + "]");
+	update_variant(variant);
+	variant.shader->build();
+
+	return *variant.shader;
+}
+
+auto Shader::
+variant_count(
 	) const
-	-> GLint
+	-> std::size_t
+{
+	return variants_.size();
+}
+
+
+
+// Reloading
+auto Shader::
+files(
+	) const
+	-> std::vector<std::string>
 {
-	if (uniforms_.find(uniform.data()) != uniforms_.end())
-		return uniforms_.at(uniform.data());
+	auto result = std::vector<std::string>();
+	for (auto const& origin : origins_)
+		for (auto const& [type, code] : origin)
+			if (type == File)
+				result.push_back(code);
 
-	return (uniforms_[uniform.data()] =
-		glGetUniformLocation(
-			program_,
-			uniform.data()));
+	return result;
 }
 
+auto Shader::
+reload(
+	)
+	-> bool
+{
+	auto const previous = source_hash_;
+	for (auto i = std::size_t(0U); i < sources_.size(); ++i)
+		sources_[i].second = expand(origins_[i]);
+	hash_sources();
 
+	// Editors often save without changes
+	if (source_hash_ == previous)
+		return false;
+
+	resubmit();
+	for (auto& [mask, variant] : variants_)
+	{
+		update_variant(variant);
+		variant.shader->resubmit();
+	}
+
+	return true;
+}
 
-// Compile shader
 auto Shader::
-compile(
-	GLenum           const type,
-	std::string_view const code
+poll(
+	)
+	-> bool
+{
+	auto done = true;
+	if (pending_)
+	{
+		if (is_ready())
+			finish();
+		else
+			done = false;
+	}
+
+	for (auto& [mask, variant] : variants_)
+		done = variant.shader->poll() && done;
+
+	return done;
+}
+
+
+
+// Uniform reflection
+auto Shader::
+reflect(
+	)
+	-> void
+{
+	uniforms_.clear();
+	uniform_table_.clear();
+
+	auto count      = GLint{};
+	auto max_length = GLint{};
+	glGetProgramiv(program_, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+	auto buffer = std::vector<char>(std::size_t(max_length) + 1U);
+	for (auto i = 0; i < count; ++i)
+	{
+		auto length = GLsizei{};
+		auto size   = GLint{};
+		auto type   = GLenum{};
+		glGetActiveUniform(program_, GLuint(i), GLsizei(buffer.size()), &length, &size, &type, buffer.data());
+
+		// Uniform block members have no location
+		auto const location = glGetUniformLocation(program_, buffer.data());
+		if (location < 0)
+			continue;
+
+		// Arrays are reported as name[0], bind uses the plain name
+		auto uniform = std::string(buffer.data(), std::size_t(length));
+		if (uniform.size() > 3U && uniform.compare(uniform.size() - 3U, 3U, "[0]") == 0)
+			uniform.resize(uniform.size() - 3U);
+
+		uniforms_.emplace_back(std::move(uniform), location);
+	}
+
+	// At most half full so probes stay short
+	auto capacity = std::size_t(8U);
+	while (capacity < uniforms_.size() * 2U)
+		capacity *= 2U;
+	uniform_table_.resize(capacity);
+	uniform_count_ = 0U;
+
+	for (auto const& [uniform, location] : uniforms_)
+		insert_uniform(Uniform::hash_name(uniform), uniform, location);
+}
+
+auto Shader::
+insert_uniform(
+	std::uint32_t    const hash,
+	std::string_view const uniform,
+	GLint            const location
 	) const
-	-> std::optional<GLuint>
+	-> void
 {
-	// Shader type
-	auto shader_type = std::string_view();
-	switch (type)
+	if ((uniform_count_ + 1U) * 2U > uniform_table_.size())
 	{
-		case GL_VERTEX_SHADER:   shader_type = "VERTEX"sv;   break;
-		case GL_FRAGMENT_SHADER: shader_type = "FRAGMENT"sv; break;
-		default:                 shader_type = "UNKNOWN"sv;  break;
+		auto table = std::move(uniform_table_);
+		uniform_table_ = std::vector<UniformSlot>(std::max(table.size() * 2U, std::size_t(8U)));
+		uniform_count_ = 0U;
+		for (auto& slot : table)
+			if (slot.hash != 0U)
+				insert_uniform(slot.hash, slot.name, slot.location);
 	}
 
-	// Create shader ID and pass code pointer for compilation
-	auto const shader = glCreateShader(type);
-	auto const shader_code = code.data();
-	glShaderSource(shader, 1, &shader_code, nullptr);
-	glCompileShader(shader);
+	auto const mask = uniform_table_.size() - 1U;
+	auto       i    = std::size_t(hash) & mask;
+	while (uniform_table_[i].hash != 0U)
+		i = (i + 1U) & mask;
+
+	uniform_table_[i] = UniformSlot{ hash, location, std::string(uniform) };
+	++uniform_count_;
+}
+
+
 
-	// Return shader ID if successful
+// Sources
+auto Shader::
+hash_sources(
+	)
+	-> void
+{
+	auto hash = fnv1a("");
+	for (auto const& [type, source] : sources_)
+	{
+		hash = fnv1a(std::to_string(type), hash);
+		hash = fnv1a(source, hash);
+	}
+
+	source_hash_ = hash;
+}
+
+
+
+auto Shader::
+resubmit(
+	)
+	-> void
+{
+	// A reload already in flight is replaced by this one
+	for (auto const& s : staged_)
+		glDeleteShader(s);
+	staged_.clear();
+	if (pending_)
+		glDeleteProgram(pending_);
+	pending_ = 0;
+
+	submit(false);
+}
+
+auto Shader::
+update_variant(
+	Variant& variant
+	) const
+	-> void
+{
+	auto& shader = *variant.shader;
+	shader.sources_.clear();
+	shader.origins_.clear();
+	for (auto const& [type, source] : sources_)
+	{
+		shader.origins_.push_back({ { Source, inject(source, variant.defines) } });
+		shader.sources_.emplace_back(type, expand(shader.origins_.back()));
+	}
+	shader.hash_sources();
+
+	variant.source = source_hash_;
+}
+
+
+
+// Program binary cache
+auto Shader::
+cache_key(
+	) const
+	-> std::uint64_t
+{
+	// Defines are in the sources, a driver update invalidates binaries
+	auto hash = source_hash_;
+
+	for (auto const info : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+	{
+		auto const string = reinterpret_cast<char const*>(glGetString(GLenum(info)));
+		hash = fnv1a(string ? string : "", hash);
+	}
+
+	return hash;
+}
+
+auto static
+cache_path(
+	std::uint64_t const key
+	)
+	-> std::filesystem::path
+{
+	auto file = std::ostringstream();
+	file << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+	return std::filesystem::path(Shader::cache_directory) / file.str();
+}
+
+auto Shader::
+load_binary(
+	std::uint64_t const key
+	) const
+	-> std::optional<GLuint>
+{
+	if (cache_directory.empty() || !GLEW_ARB_get_program_binary)
+		return std::nullopt;
+
+	auto file = std::ifstream(cache_path(key), std::ios::binary);
+	if (!file)
+		return std::nullopt;
+
+	// Binary format followed by the driver's blob
+	auto format = GLenum{};
+	file.read(reinterpret_cast<char*>(&format), sizeof(format));
+	auto const binary = std::vector<char>(
+		std::istreambuf_iterator<char>(file),
+		std::istreambuf_iterator<char>());
+	if (binary.empty())
+		return std::nullopt;
+
+	auto const program = glCreateProgram();
+	glProgramBinary(program, format, binary.data(), GLsizei(binary.size()));
+
+	// Drivers may reject binaries at any time, compiling is the fallback
 	auto success = GLint{};
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
 	if (success)
-		return shader;
+		return program;
 
-	// Get compilation log
-	auto log_length = GLint{};
-	glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
+	glDeleteProgram(program);
+	return std::nullopt;
+}
+
+auto Shader::
+save_binary(
+	std::uint64_t const key,
+	GLuint        const program
+	) const
+	-> void
+{
+	if (cache_directory.empty() || !GLEW_ARB_get_program_binary)
+		return;
 
-	auto const log = std::make_unique<char[]>(std::size_t(log_length));
-	glGetShaderInfoLog(shader, log_length, &log_length, log.get());
+	auto length = GLint{};
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
 
-	std::cerr << "ERROR: " <<
-		name << " " <<
-		shader_type << " shader failed to compile. Log: " <<
-		log.get() << std::endl;
+	auto format = GLenum{};
+	auto binary = std::vector<char>(std::size_t(length));
+	glGetProgramBinary(program, length, &length, &format, binary.data());
 
-	// Clean up
-	glDeleteShader(shader);
-	return std::nullopt;
+	auto error = std::error_code();
+	std::filesystem::create_directories(cache_directory, error);
+
+	auto file = std::ofstream(cache_path(key), std::ios::binary);
+	file.write(reinterpret_cast<char const*>(&format), sizeof(format));
+	file.write(binary.data(), length);
+
+	if (!file)
+		std::cerr << "ERROR: Could not cache program binary for shader " <<
+			name << std::endl;
+}
+
+
+
+// Compile shader
+auto Shader::
+compile(
+	GLenum           const type,
+	std::string_view const code
+	) const
+	-> GLuint
+{
+	// Create shader ID and pass code pointer for compilation
+	auto const shader = glCreateShader(type);
+	auto const shader_code = code.data();
+	glShaderSource(shader, 1, &shader_code, nullptr);
+	glCompileShader(shader);
+
+	// Status is checked after linking so the driver can work in parallel
+	return shader;
 }
 
 auto Shader::
 link(
 	) const
-	-> std::optional<GLuint>
+	-> GLuint
 {
 	auto const program = glCreateProgram();
-	for (auto const& s : shaders_)
+	for (auto const& s : staged_)
 		glAttachShader(program, s);
+
+	if (caching_ && GLEW_ARB_get_program_binary && !cache_directory.empty())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(program);
 
-	// Returns program ID if successful
+	return program;
+}
+
+auto Shader::
+check(
+	GLuint const program
+	) const
+	-> bool
+{
+	// Returns true if successful
 	auto success = GLint{};
 	glGetProgramiv(program, GL_LINK_STATUS, &success);
 	if (success)
-		return program;
+		return true;
+
+	// Get compilation logs
+	for (auto const& s : staged_)
+	{
+		glGetShaderiv(s, GL_COMPILE_STATUS, &success);
+		if (success)
+			continue;
+
+		// Shader type
+		auto type = GLint{};
+		glGetShaderiv(s, GL_SHADER_TYPE, &type);
+
+		auto shader_type = std::string_view();
+		switch (type)
+		{
+			case GL_VERTEX_SHADER:   shader_type = "VERTEX"sv;   break;
+			case GL_FRAGMENT_SHADER: shader_type = "FRAGMENT"sv; break;
+			default:                 shader_type = "UNKNOWN"sv;  break;
+		}
+
+		auto log_length = GLint{};
+		glGetShaderiv(s, GL_INFO_LOG_LENGTH, &log_length);
+
+		auto const log = std::make_unique<char[]>(std::size_t(log_length) + 1U);
+		glGetShaderInfoLog(s, log_length, &log_length, log.get());
+
+		std::cerr << "ERROR: " <<
+			name << " " <<
+			shader_type << " shader failed to compile. Log: " <<
+			log.get() << std::endl;
+	}
 
 	// Get link log
 	auto log_length = GLint{};
 	glGetProgramiv(program, GL_INFO_LOG_LENGTH, &log_length);
 
-	auto const log = std::make_unique<char[]>(std::size_t(log_length));
+	auto const log = std::make_unique<char[]>(std::size_t(log_length) + 1U);
 	glGetProgramInfoLog(program, log_length, &log_length, log.get());
 
 	std::cerr << "ERROR: build failed for shader " <<
 		name << ". Log: " <<
 		log.get() << std::endl;
 
-	// Clean up
-	glDeleteProgram(program);
-	return std::nullopt;
+	return false;
 }
 
 } // namespace ogl
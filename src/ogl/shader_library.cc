@@ -0,0 +1,153 @@
+#include <e3d/ogl/shader_library.hh>
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#include <e3d/ogl/profiler.hh>
+
+
+
+namespace ogl
+{
+
+// Shaders
+auto ShaderLibrary::
+create(
+	std::string const& name
+	)
+	-> std::shared_ptr<Shader>
+{
+	auto& shader = shaders_[name];
+	if (shader)
+		std::cerr << "ERROR: Shader " <<
+			name << " already exists in library, replacing it" << std::endl;
+
+	shader = std::make_shared<Shader>(name);
+	queued_.push_back(shader);
+	return shader;
+}
+
+auto ShaderLibrary::
+get(
+	std::string_view const name
+	) const
+	-> std::shared_ptr<Shader>
+{
+	auto const it = shaders_.find(std::string(name));
+	if (it == shaders_.end())
+	{
+		std::cerr << "ERROR: No shader " <<
+			name << " in library" << std::endl;
+		return nullptr;
+	}
+
+	return it->second;
+}
+
+
+
+// Building
+auto ShaderLibrary::
+build(
+	)
+	-> bool
+{
+	auto const scope = profiler::Scope("shader build");
+
+	submit();
+	while (!poll())
+		std::this_thread::yield();
+
+	return std::all_of(shaders_.begin(), shaders_.end(),
+		[](auto const& s) { return s.second->is_valid(); });
+}
+
+auto ShaderLibrary::
+submit(
+	)
+	-> void
+{
+	// Let the driver use as many compiler threads as it likes
+	auto static threads_set = false;
+	if (!threads_set && GLEW_KHR_parallel_shader_compile)
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFFU);
+	threads_set = true;
+
+	if (pending_.empty())
+		start_ = std::chrono::steady_clock::now();
+
+	for (auto& s : queued_)
+	{
+		s->submit();
+		pending_.push_back(std::move(s));
+	}
+	queued_.clear();
+}
+
+auto ShaderLibrary::
+poll(
+	)
+	-> bool
+{
+	auto const finished = std::remove_if(pending_.begin(), pending_.end(),
+		[](std::shared_ptr<Shader> const& s)
+		{
+			if (!s->is_ready())
+				return false;
+
+			s->finish();
+			return true;
+		});
+	pending_.erase(finished, pending_.end());
+
+	if (!pending_.empty())
+		return false;
+
+	time_ = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start_).count();
+	return true;
+}
+
+
+
+// Statistics
+auto ShaderLibrary::
+size(
+	) const
+	-> std::size_t
+{
+	return shaders_.size();
+}
+
+auto ShaderLibrary::
+build_time(
+	) const
+	-> double
+{
+	return time_;
+}
+
+auto ShaderLibrary::
+report(
+	) const
+	-> void
+{
+	// Slowest first
+	auto sorted = std::vector<Shader const*>();
+	for (auto const& s : shaders_)
+		sorted.push_back(s.second.get());
+	std::sort(sorted.begin(), sorted.end(),
+		[](Shader const* a, Shader const* b) { return a->build_time() > b->build_time(); });
+
+	std::cout << "Shader library built " <<
+		sorted.size() << " programs in " <<
+		time_ << "ms" << std::endl;
+	for (auto const s : sorted)
+		std::cout << "- " <<
+			s->name << "\t| " <<
+			s->build_time() << "ms" <<
+			(s->is_valid() ? "" : "\t| FAILED") << std::endl;
+}
+
+} // namespace ogl
@@ -0,0 +1,406 @@
+#include <e3d/ogl/state.hh>
+
+#include <array>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+
+
+
+namespace ogl::state
+{
+
+// Details
+// Nothing matches an unknown binding, so the next call is always issued
+auto static constexpr unknown_ = std::numeric_limits<GLuint>::max();
+
+// Tracked targets
+auto static constexpr buffer_targets_ = std::array<GLenum, 6>{
+	GL_ARRAY_BUFFER,
+	GL_PIXEL_PACK_BUFFER,
+	GL_PIXEL_UNPACK_BUFFER,
+	GL_DRAW_INDIRECT_BUFFER,
+	GL_UNIFORM_BUFFER,
+	GL_COPY_WRITE_BUFFER };
+
+auto static constexpr texture_targets_ = std::array<GLenum, 5>{
+	GL_TEXTURE_2D,
+	GL_TEXTURE_2D_ARRAY,
+	GL_TEXTURE_2D_MULTISAMPLE,
+	GL_TEXTURE_CUBE_MAP,
+	GL_TEXTURE_3D };
+
+auto static constexpr texture_units_ = std::size_t(32U);
+
+// Objects
+auto static program_          = unknown_;
+auto static vertex_array_     = unknown_;
+auto static draw_framebuffer_ = unknown_;
+auto static read_framebuffer_ = unknown_;
+auto static buffers_          = std::array<GLuint, buffer_targets_.size()>();
+auto static active_unit_      = unknown_;
+auto static textures_         = std::array<std::array<GLuint, texture_targets_.size()>, texture_units_>();
+
+// Fixed function
+auto static capabilities_ = std::unordered_map<GLenum, bool>();
+auto static blend_        = std::array<GLenum, 2>{ unknown_, unknown_ };
+auto static depth_func_   = unknown_;
+auto static depth_mask_   = std::optional<bool>();
+auto static viewport_     = std::array<GLint, 4>{ -1, -1, -1, -1 };
+
+// Counters
+auto static current_ = Counters();
+auto static last_    = Counters();
+
+
+
+// Record a call, returns whether it has to be issued
+auto static
+count(
+	bool const issue
+	)
+	-> bool
+{
+	if (issue)
+		++current_.issued;
+	else
+		++current_.skipped;
+	return issue;
+}
+
+template<std::size_t N>
+auto static
+index_of(
+	std::array<GLenum, N> const& targets,
+	GLenum                const  target
+	)
+	-> std::optional<std::size_t>
+{
+	for (auto i = std::size_t(0U); i < N; ++i)
+		if (targets[i] == target)
+			return i;
+	return std::nullopt;
+}
+
+
+
+// Frames
+auto
+invalidate(
+	)
+	-> void
+{
+	program_          = unknown_;
+	vertex_array_     = unknown_;
+	draw_framebuffer_ = unknown_;
+	read_framebuffer_ = unknown_;
+	active_unit_      = unknown_;
+	buffers_.fill(unknown_);
+	for (auto& unit : textures_)
+		unit.fill(unknown_);
+
+	capabilities_.clear();
+	blend_      = { unknown_, unknown_ };
+	depth_func_ = unknown_;
+	depth_mask_ = std::nullopt;
+	viewport_   = { -1, -1, -1, -1 };
+}
+
+auto
+new_frame(
+	)
+	-> void
+{
+	last_    = current_;
+	current_ = Counters();
+}
+
+auto
+counters(
+	)
+	-> Counters
+{
+	return last_;
+}
+
+
+
+// Objects
+auto
+use_program(
+	GLuint const program
+	)
+	-> void
+{
+	if (count(program != program_))
+		glUseProgram(program_ = program);
+}
+
+auto
+current_program(
+	)
+	-> GLuint
+{
+	// Only unknown before anything was bound through the cache
+	if (program_ == unknown_)
+	{
+		auto p = GLint{};
+		glGetIntegerv(GL_CURRENT_PROGRAM, &p);
+		program_ = GLuint(p);
+	}
+
+	return program_;
+}
+
+auto
+bind_vertex_array(
+	GLuint const vertex_array
+	)
+	-> void
+{
+	if (count(vertex_array != vertex_array_))
+		glBindVertexArray(vertex_array_ = vertex_array);
+}
+
+auto
+bind_framebuffer(
+	GLenum const target,
+	GLuint const framebuffer
+	)
+	-> void
+{
+	auto const draw = target != GL_READ_FRAMEBUFFER;
+	auto const read = target != GL_DRAW_FRAMEBUFFER;
+
+	auto const changed =
+		(draw && framebuffer != draw_framebuffer_) ||
+		(read && framebuffer != read_framebuffer_);
+	if (!count(changed))
+		return;
+
+	if (draw)
+		draw_framebuffer_ = framebuffer;
+	if (read)
+		read_framebuffer_ = framebuffer;
+	glBindFramebuffer(target, framebuffer);
+}
+
+auto
+current_framebuffer(
+	GLenum const target
+	)
+	-> GLuint
+{
+	return target == GL_READ_FRAMEBUFFER
+		? read_framebuffer_
+		: draw_framebuffer_;
+}
+
+auto
+bind_buffer(
+	GLenum const target,
+	GLuint const buffer
+	)
+	-> void
+{
+	auto const i = index_of(buffer_targets_, target);
+	if (!i.has_value())
+	{
+		count(true);
+		glBindBuffer(target, buffer);
+		return;
+	}
+
+	if (count(buffer != buffers_[*i]))
+		glBindBuffer(target, buffers_[*i] = buffer);
+}
+
+auto
+active_texture(
+	GLuint const unit
+	)
+	-> void
+{
+	if (count(unit != active_unit_))
+		glActiveTexture(GL_TEXTURE0 + (active_unit_ = unit));
+}
+
+auto
+bind_texture(
+	GLuint const unit,
+	GLenum const target,
+	GLuint const texture
+	)
+	-> void
+{
+	auto const i = index_of(texture_targets_, target);
+	if (i.has_value() && unit < texture_units_)
+	{
+		if (!count(texture != textures_[unit][*i]))
+			return;
+		textures_[unit][*i] = texture;
+	}
+	else
+		count(true);
+
+	active_texture(unit);
+	glBindTexture(target, texture);
+}
+
+auto
+bind_texture_for_edit(
+	GLuint const unit,
+	GLenum const target,
+	GLuint const texture
+	)
+	-> void
+{
+	// Edits go to the active unit, which a cache hit above would not select
+	active_texture(unit);
+	bind_texture(unit, target, texture);
+}
+
+
+
+// Deleted names
+auto
+release_program(
+	GLuint const program
+	)
+	-> void
+{
+	// Deleting the current program leaves it in use until another is bound
+	if (program_ == program)
+		program_ = unknown_;
+}
+
+auto
+release_vertex_array(
+	GLuint const vertex_array
+	)
+	-> void
+{
+	if (vertex_array_ == vertex_array)
+		vertex_array_ = 0U;
+}
+
+auto
+release_framebuffer(
+	GLuint const framebuffer
+	)
+	-> void
+{
+	if (draw_framebuffer_ == framebuffer)
+		draw_framebuffer_ = 0U;
+	if (read_framebuffer_ == framebuffer)
+		read_framebuffer_ = 0U;
+}
+
+auto
+release_buffer(
+	GLuint const buffer
+	)
+	-> void
+{
+	for (auto& b : buffers_)
+		if (b == buffer)
+			b = 0U;
+}
+
+auto
+release_texture(
+	GLuint const texture
+	)
+	-> void
+{
+	for (auto& unit : textures_)
+		for (auto& t : unit)
+			if (t == texture)
+				t = 0U;
+}
+
+
+
+// Fixed function state
+auto
+enable(
+	GLenum const capability,
+	bool   const enabled
+	)
+	-> void
+{
+	auto const it = capabilities_.find(capability);
+	if (!count(it == capabilities_.end() || it->second != enabled))
+		return;
+
+	capabilities_[capability] = enabled;
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+}
+
+auto
+disable(
+	GLenum const capability
+	)
+	-> void
+{
+	enable(capability, false);
+}
+
+auto
+blend_func(
+	GLenum const source,
+	GLenum const destination
+	)
+	-> void
+{
+	if (count(source != blend_[0] || destination != blend_[1]))
+	{
+		blend_ = { source, destination };
+		glBlendFunc(source, destination);
+	}
+}
+
+auto
+depth_func(
+	GLenum const function
+	)
+	-> void
+{
+	if (count(function != depth_func_))
+		glDepthFunc(depth_func_ = function);
+}
+
+auto
+depth_mask(
+	bool const write
+	)
+	-> void
+{
+	if (count(depth_mask_ != write))
+	{
+		depth_mask_ = write;
+		glDepthMask(write ? GL_TRUE : GL_FALSE);
+	}
+}
+
+auto
+viewport(
+	GLint   const x,
+	GLint   const y,
+	GLsizei const width,
+	GLsizei const height
+	)
+	-> void
+{
+	auto const v = std::array<GLint, 4>{ x, y, width, height };
+	if (count(v != viewport_))
+	{
+		viewport_ = v;
+		glViewport(x, y, width, height);
+	}
+}
+
+} // namespace ogl::state
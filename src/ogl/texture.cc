@@ -1,9 +1,21 @@
 #include <e3d/ogl/texture.hh>
 
+#include <utility>
+
+#include <e3d/ogl/state.hh>
+
 namespace ogl
 {
 
 // Constructors
+Texture::
+Texture(
+	) :
+	ready_(false)
+{
+	glGenTextures(1, &id_);
+}
+
 Texture::
 Texture(
 	GLuint const width,
@@ -11,15 +23,50 @@ Texture(
 	) :
 	width_(width),
 	height_(height),
-	type_(GL_TEXTURE_2D)
+	size_bytes_(std::size_t(width) * height * 4U)
 {
 	glGenTextures(1, &id_);
 }
 
+Texture::
+Texture(
+	Texture&& other
+	) noexcept :
+	id_(std::exchange(other.id_, 0U)),
+	width_(other.width_),
+	height_(other.height_),
+	type_(other.type_),
+	format_(other.format_),
+	levels_(other.levels_),
+	size_bytes_(other.size_bytes_),
+	ready_(other.ready_)
+{}
+
+auto Texture::
+operator=(
+	Texture&& other
+	) noexcept
+	-> Texture&
+{
+	std::swap(id_, other.id_);
+	width_      = other.width_;
+	height_     = other.height_;
+	type_       = other.type_;
+	format_     = other.format_;
+	levels_     = other.levels_;
+	size_bytes_ = other.size_bytes_;
+	ready_      = other.ready_;
+	return *this;
+}
+
 Texture::
 ~Texture(
 	)
 {
+	if (id_ == 0U)
+		return;
+
+	state::release_texture(id_);
 	glDeleteTextures(1, &id_);
 }
 
@@ -58,4 +105,36 @@ type(
 	return type_;
 }
 
+auto Texture::
+format(
+	) const
+	-> GLenum
+{
+	return format_;
+}
+
+auto Texture::
+levels(
+	) const
+	-> GLuint
+{
+	return levels_;
+}
+
+auto Texture::
+size_bytes(
+	) const
+	-> std::size_t
+{
+	return size_bytes_;
+}
+
+auto Texture::
+is_ready(
+	) const
+	-> bool
+{
+	return ready_;
+}
+
 } // namespace ogl
@@ -0,0 +1,805 @@
+#include <e3d/ogl/texture_loader.hh>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <sstream>
+
+#include <e3d/ogl/image.hh>
+#include <e3d/ogl/profiler.hh>
+#include <e3d/ogl/state.hh>
+
+
+
+namespace ogl
+{
+
+// Details
+auto static
+fnv1a(
+	std::string_view const data,
+	std::uint64_t          hash = 14695981039346656037ULL
+	)
+	-> std::uint64_t
+{
+	for (auto const c : data)
+		hash = (hash ^ std::uint8_t(c)) * 1099511628211ULL;
+	return hash;
+}
+
+auto static
+milliseconds_since(
+	profiler::clock::time_point const start
+	)
+	-> double
+{
+	return std::chrono::duration<double, std::milli>(
+		profiler::clock::now() - start).count();
+}
+
+auto static
+is_compressed(
+	GLenum const format
+	)
+	-> bool
+{
+	return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+		|| format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+// Bytes in a level of one of the formats decode produces, zero otherwise
+auto static
+level_size(
+	GLenum const format,
+	GLuint const width,
+	GLuint const height
+	)
+	-> std::uint64_t
+{
+	if (format == GL_RGBA8)
+		return std::uint64_t(width) * height * 4U;
+
+	if (!is_compressed(format))
+		return 0U;
+
+	auto const block_size = format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT ? 16U : 8U;
+	return std::uint64_t((width + 3U) / 4U) * ((height + 3U) / 4U) * block_size;
+}
+
+
+
+// Mip chain, 2x2 box filter down to 1x1
+auto static
+build_mips(
+	Image const& image
+	)
+	-> std::vector<std::vector<std::uint8_t>>
+{
+	auto levels = std::vector<std::vector<std::uint8_t>>{ image.pixels };
+
+	auto width  = image.width;
+	auto height = image.height;
+	while (width > 1U || height > 1U)
+	{
+		auto const& source = levels.back();
+		auto const  w      = std::max(width / 2U, 1U);
+		auto const  h      = std::max(height / 2U, 1U);
+
+		auto target = std::vector<std::uint8_t>(std::size_t(w) * h * 4U);
+		for (auto y = 0U; y < h; ++y)
+		{
+			auto const y0 = std::min(y * 2U, height - 1U);
+			auto const y1 = std::min(y * 2U + 1U, height - 1U);
+			for (auto x = 0U; x < w; ++x)
+			{
+				auto const x0 = std::min(x * 2U, width - 1U);
+				auto const x1 = std::min(x * 2U + 1U, width - 1U);
+				for (auto c = 0U; c < 4U; ++c)
+				{
+					auto const at = [&](std::uint32_t const sx, std::uint32_t const sy)
+					{
+						return unsigned(source[(std::size_t(sy) * width + sx) * 4U + c]);
+					};
+					target[(std::size_t(y) * w + x) * 4U + c] = std::uint8_t(
+						(at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1) + 2U) / 4U);
+				}
+			}
+		}
+
+		levels.push_back(std::move(target));
+		width  = w;
+		height = h;
+	}
+
+	return levels;
+}
+
+
+
+// Block compression, endpoints from the bounding box of each 4x4 block
+auto static
+to_565(
+	std::array<int, 3> const& colour
+	)
+	-> std::uint16_t
+{
+	return std::uint16_t(
+		(colour[0] >> 3) << 11 |
+		(colour[1] >> 2) << 5 |
+		(colour[2] >> 3));
+}
+
+auto static
+from_565(
+	std::uint16_t const colour
+	)
+	-> std::array<int, 3>
+{
+	auto const r = (colour >> 11) & 31;
+	auto const g = (colour >> 5) & 63;
+	auto const b = colour & 31;
+	return { r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2 };
+}
+
+auto static
+encode_colour(
+	std::uint8_t const* block,
+	std::uint8_t*       out
+	)
+	-> void
+{
+	auto low  = std::array<int, 3>{ 255, 255, 255 };
+	auto high = std::array<int, 3>{ 0, 0, 0 };
+	for (auto i = 0U; i < 16U; ++i)
+		for (auto c = 0U; c < 3U; ++c)
+		{
+			low[c]  = std::min<int>(low[c], block[i * 4U + c]);
+			high[c] = std::max<int>(high[c], block[i * 4U + c]);
+		}
+
+	// Pull the endpoints in a little, extremes are rarely worth hitting exactly
+	for (auto c = 0U; c < 3U; ++c)
+	{
+		auto const inset = (high[c] - low[c]) / 16;
+		low[c]  += inset;
+		high[c] -= inset;
+	}
+
+	auto c0 = to_565(high);
+	auto c1 = to_565(low);
+	if (c0 < c1)
+		std::swap(c0, c1);
+
+	out[0] = std::uint8_t(c0);
+	out[1] = std::uint8_t(c0 >> 8U);
+	out[2] = std::uint8_t(c1);
+	out[3] = std::uint8_t(c1 >> 8U);
+
+	// Equal endpoints select three colour mode, where index 0 is still exact
+	auto indices = std::uint32_t(0U);
+	if (c0 != c1)
+	{
+		auto const p0 = from_565(c0);
+		auto const p1 = from_565(c1);
+		auto palette = std::array<std::array<int, 3>, 4>{ p0, p1 };
+		for (auto c = 0U; c < 3U; ++c)
+		{
+			palette[2][c] = (2 * p0[c] + p1[c]) / 3;
+			palette[3][c] = (p0[c] + 2 * p1[c]) / 3;
+		}
+
+		for (auto i = 0U; i < 16U; ++i)
+		{
+			auto best  = 0U;
+			auto error = std::numeric_limits<int>::max();
+			for (auto p = 0U; p < 4U; ++p)
+			{
+				auto e = 0;
+				for (auto c = 0U; c < 3U; ++c)
+				{
+					auto const d = palette[p][c] - block[i * 4U + c];
+					e += d * d;
+				}
+				if (e < error)
+				{
+					error = e;
+					best  = p;
+				}
+			}
+			indices |= best << (i * 2U);
+		}
+	}
+
+	for (auto i = 0U; i < 4U; ++i)
+		out[4U + i] = std::uint8_t(indices >> (i * 8U));
+}
+
+auto static
+encode_alpha(
+	std::uint8_t const* block,
+	std::uint8_t*       out
+	)
+	-> void
+{
+	auto a0 = 0;
+	auto a1 = 255;
+	for (auto i = 0U; i < 16U; ++i)
+	{
+		a0 = std::max<int>(a0, block[i * 4U + 3U]);
+		a1 = std::min<int>(a1, block[i * 4U + 3U]);
+	}
+
+	out[0] = std::uint8_t(a0);
+	out[1] = std::uint8_t(a1);
+
+	// Eight interpolated values when a0 > a1
+	auto palette = std::array<int, 8>{ a0, a1 };
+	for (auto p = 1; p < 7; ++p)
+		palette[std::size_t(p) + 1U] = ((7 - p) * a0 + p * a1) / 7;
+
+	auto indices = std::uint64_t(0U);
+	if (a0 != a1)
+		for (auto i = 0U; i < 16U; ++i)
+		{
+			auto best  = 0U;
+			auto error = std::numeric_limits<int>::max();
+			for (auto p = 0U; p < 8U; ++p)
+			{
+				auto const e = std::abs(palette[p] - block[i * 4U + 3U]);
+				if (e < error)
+				{
+					error = e;
+					best  = p;
+				}
+			}
+			indices |= std::uint64_t(best) << (i * 3U);
+		}
+
+	for (auto i = 0U; i < 6U; ++i)
+		out[2U + i] = std::uint8_t(indices >> (i * 8U));
+}
+
+// BC1 (8 bytes per block) or BC3 (16 bytes per block)
+auto static
+compress_level(
+	std::vector<std::uint8_t> const& pixels,
+	std::uint32_t             const  width,
+	std::uint32_t             const  height,
+	bool                      const  alpha
+	)
+	-> std::vector<std::uint8_t>
+{
+	auto const blocks_x   = (width + 3U) / 4U;
+	auto const blocks_y   = (height + 3U) / 4U;
+	auto const block_size = alpha ? 16U : 8U;
+
+	auto result = std::vector<std::uint8_t>(std::size_t(blocks_x) * blocks_y * block_size);
+	auto block  = std::array<std::uint8_t, 64>();
+	for (auto by = 0U; by < blocks_y; ++by)
+		for (auto bx = 0U; bx < blocks_x; ++bx)
+		{
+			// Blocks past the edge repeat the last row and column
+			for (auto y = 0U; y < 4U; ++y)
+				for (auto x = 0U; x < 4U; ++x)
+				{
+					auto const sx = std::min(bx * 4U + x, width - 1U);
+					auto const sy = std::min(by * 4U + y, height - 1U);
+					std::memcpy(&block[(y * 4U + x) * 4U], &pixels[(std::size_t(sy) * width + sx) * 4U], 4U);
+				}
+
+			auto const out = &result[(std::size_t(by) * blocks_x + bx) * block_size];
+			if (alpha)
+			{
+				encode_alpha(block.data(), out);
+				encode_colour(block.data(), out + 8U);
+			}
+			else
+				encode_colour(block.data(), out);
+		}
+
+	return result;
+}
+
+
+
+// Disk cache, a header then every level
+auto static constexpr cache_magic = std::uint32_t(0x54443345U);
+
+auto static
+cache_path(
+	std::string const& directory,
+	std::uint64_t      key
+	)
+	-> std::filesystem::path
+{
+	auto file = std::ostringstream();
+	file << std::hex << std::setw(16) << std::setfill('0') << key << ".tex";
+	return std::filesystem::path(directory) / file.str();
+}
+
+// Changes to the file or the options invalidate the entry
+auto static
+cache_key(
+	std::string const& path,
+	bool               compress
+	)
+	-> std::optional<std::uint64_t>
+{
+	auto       error = std::error_code();
+	auto const size  = std::filesystem::file_size(path, error);
+	if (error)
+		return std::nullopt;
+	auto const time = std::filesystem::last_write_time(path, error);
+	if (error)
+		return std::nullopt;
+
+	auto hash = fnv1a(path);
+	hash = fnv1a(std::to_string(size), hash);
+	hash = fnv1a(std::to_string(time.time_since_epoch().count()), hash);
+	return fnv1a(compress ? "bc" : "rgba", hash);
+}
+
+template<typename T>
+auto static
+read_value(
+	std::ifstream& file
+	)
+	-> T
+{
+	auto value = T{};
+	file.read(reinterpret_cast<char*>(&value), sizeof(value));
+	return value;
+}
+
+template<typename T>
+auto static
+write_value(
+	std::ofstream& file,
+	T const&       value
+	)
+	-> void
+{
+	file.write(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+
+
+// Constructors
+TextureLoader::
+TextureLoader(
+	unsigned threads
+	) :
+	compressed_(GLEW_EXT_texture_compression_s3tc)
+{
+	if (threads == 0U)
+		threads = std::max(std::thread::hardware_concurrency(), 2U) - 1U;
+
+	for (auto i = 0U; i < threads; ++i)
+		threads_.emplace_back(&TextureLoader::run, this);
+}
+
+TextureLoader::
+~TextureLoader(
+	)
+{
+	{
+		auto const lock = std::lock_guard(mutex_);
+		stopping_ = true;
+		requests_.clear();
+	}
+	condition_.notify_all();
+	for (auto& thread : threads_)
+		thread.join();
+
+	if (buffer_ != 0U)
+	{
+		state::release_buffer(buffer_);
+		glDeleteBuffers(1, &buffer_);
+	}
+}
+
+
+
+// Loading
+auto TextureLoader::
+load(
+	std::string const& path,
+	std::string const& set
+	)
+	-> std::shared_ptr<Texture>
+{
+	auto& loaded = loaded_[path];
+	if (auto texture = loaded.lock())
+		return texture;
+
+	auto texture = std::make_shared<Texture>();
+	loaded = texture;
+
+	auto job     = Job();
+	job.texture  = texture;
+	job.path     = path;
+	job.set      = set;
+	job.compress = compress && compressed_;
+
+	{
+		auto const lock = std::lock_guard(mutex_);
+		requests_.push_back(std::move(job));
+	}
+	condition_.notify_one();
+
+	return texture;
+}
+
+auto TextureLoader::
+load_material(
+	obj::Material const& material,
+	std::string const&   directory
+	)
+	-> std::map<std::string, std::shared_ptr<Texture>>
+{
+	auto const maps = std::array<std::pair<char const*, std::string const*>, 6>{{
+		{ "map_Ka",   &material.ambient_texture_map },
+		{ "map_Kd",   &material.diffuse_texture_map },
+		{ "map_Ks",   &material.specular_texture_map },
+		{ "map_Ns",   &material.specular_highlight_map },
+		{ "map_d",    &material.alpha_texture_map },
+		{ "map_bump", &material.bump_map } }};
+
+	auto textures = std::map<std::string, std::shared_ptr<Texture>>();
+	for (auto const& [name, file] : maps)
+		if (!file->empty())
+			textures[name] = load(
+				(std::filesystem::path(directory) / *file).lexically_normal().string(),
+				material.name);
+
+	return textures;
+}
+
+auto TextureLoader::
+update(
+	)
+	-> void
+{
+	auto const scope = profiler::Scope("texture upload");
+
+	{
+		auto const lock = std::lock_guard(mutex_);
+		std::move(decoded_.begin(), decoded_.end(), std::back_inserter(uploads_));
+		decoded_.clear();
+	}
+
+	auto uploaded = std::size_t(0U);
+	while (!uploads_.empty())
+	{
+		auto& job = uploads_.front();
+		if (job.failed)
+		{
+			uploads_.pop_front();
+			continue;
+		}
+
+		// Stop at the budget, but always make progress
+		auto const size = job.levels[next_level_].data.size();
+		if (uploaded > 0U && uploaded + size > upload_budget)
+			break;
+
+		auto const start = profiler::clock::now();
+		uploaded += upload(job, next_level_++);
+
+		auto& stats = stats_[job.set];
+		stats.upload += milliseconds_since(start);
+
+		if (next_level_ < job.levels.size())
+			continue;
+
+		job.texture->ready_ = true;
+		stats.textures += 1U;
+		stats.bytes    += job.texture->size_bytes_;
+		stats.decode   += job.decode;
+
+		uploads_.pop_front();
+		next_level_ = 0U;
+	}
+
+	// Later pixel transfers expect client memory
+	if (uploaded > 0U)
+		state::bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0U);
+}
+
+auto TextureLoader::
+flush(
+	)
+	-> void
+{
+	auto const budget = upload_budget;
+	upload_budget = std::numeric_limits<std::size_t>::max();
+
+	while (pending() > 0U)
+	{
+		update();
+		std::this_thread::yield();
+	}
+
+	upload_budget = budget;
+}
+
+auto TextureLoader::
+pending(
+	)
+	-> std::size_t
+{
+	auto const lock = std::lock_guard(mutex_);
+	return requests_.size() + working_ + decoded_.size() + uploads_.size();
+}
+
+
+
+// Statistics
+auto TextureLoader::
+stats(
+	) const
+	-> std::map<std::string, Stats> const&
+{
+	return stats_;
+}
+
+auto TextureLoader::
+report(
+	) const
+	-> void
+{
+	auto total = Stats();
+	std::cout << "Texture loader" << std::endl;
+	for (auto const& [set, s] : stats_)
+	{
+		std::cout << "- " <<
+			(set.empty() ? "(default)" : set) << "\t| " <<
+			s.textures << " textures\t| " <<
+			double(s.bytes) / (1024.0 * 1024.0) << "MiB\t| decode " <<
+			s.decode << "ms\t| upload " <<
+			s.upload << "ms" << std::endl;
+
+		total.textures += s.textures;
+		total.bytes    += s.bytes;
+		total.decode   += s.decode;
+		total.upload   += s.upload;
+	}
+
+	std::cout << "Total " <<
+		total.textures << " textures, " <<
+		double(total.bytes) / (1024.0 * 1024.0) << "MiB, decode " <<
+		total.decode << "ms, upload " <<
+		total.upload << "ms" << std::endl;
+}
+
+
+
+// Worker threads
+auto TextureLoader::
+run(
+	)
+	-> void
+{
+	for (;;)
+	{
+		auto job = Job();
+		{
+			auto lock = std::unique_lock(mutex_);
+			condition_.wait(lock, [this]() { return stopping_ || !requests_.empty(); });
+			if (stopping_)
+				return;
+
+			job = std::move(requests_.front());
+			requests_.pop_front();
+			++working_;
+		}
+
+		decode(job);
+
+		{
+			auto const lock = std::lock_guard(mutex_);
+			decoded_.push_back(std::move(job));
+			--working_;
+		}
+	}
+}
+
+auto TextureLoader::
+decode(
+	Job& job
+	) const
+	-> void
+{
+	auto const start = profiler::clock::now();
+	auto const key   = cache_directory.empty()
+		? std::nullopt
+		: cache_key(job.path, job.compress);
+
+	// Cached mip chain
+	if (key.has_value())
+	{
+		auto file = std::ifstream(cache_path(cache_directory, *key), std::ios::binary);
+		if (file && read_value<std::uint32_t>(file) == cache_magic)
+		{
+			// Sizes come from disk, each must match its level and fit in what
+			// is left of the file before anything is allocated for it
+			auto const position = file.tellg();
+			file.seekg(0, std::ios::end);
+			auto const end = std::uint64_t(file.tellg());
+			file.seekg(position);
+
+			auto valid = true;
+			job.format = read_value<GLenum>(file);
+			job.levels.resize(std::min(read_value<std::uint32_t>(file), 32U));
+			for (auto& level : job.levels)
+			{
+				level.width  = read_value<GLuint>(file);
+				level.height = read_value<GLuint>(file);
+
+				auto const size     = read_value<std::uint32_t>(file);
+				auto const expected = level_size(job.format, level.width, level.height);
+				if (!file || expected == 0U || size != expected || size > end - std::uint64_t(file.tellg()))
+				{
+					valid = false;
+					break;
+				}
+
+				level.data.resize(size);
+				file.read(reinterpret_cast<char*>(level.data.data()), std::streamsize(level.data.size()));
+			}
+
+			job.cached = valid && file && !job.levels.empty();
+			if (job.cached)
+			{
+				job.decode = milliseconds_since(start);
+				return;
+			}
+
+			std::cerr << "WARNING: Ignoring corrupt texture cache entry for " <<
+				job.path << std::endl;
+			job.levels.clear();
+		}
+	}
+
+	auto image = read_image(job.path);
+	if (!image || image->width == 0U || image->height == 0U)
+	{
+		job.failed = true;
+		return;
+	}
+
+	auto rgba = image->to_rgba();
+	rgba.flip_vertical();
+
+	auto alpha = false;
+	for (auto i = std::size_t(3U); i < rgba.pixels.size() && !alpha; i += 4U)
+		alpha = rgba.pixels[i] != 255U;
+
+	job.format = !job.compress
+		? GL_RGBA8
+		: alpha
+			? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+			: GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+	auto width  = rgba.width;
+	auto height = rgba.height;
+	for (auto& pixels : build_mips(rgba))
+	{
+		auto level   = Level();
+		level.width  = width;
+		level.height = height;
+		level.data   = job.compress
+			? compress_level(pixels, width, height, alpha)
+			: std::move(pixels);
+		job.levels.push_back(std::move(level));
+
+		width  = std::max(width / 2U, 1U);
+		height = std::max(height / 2U, 1U);
+	}
+
+	if (key.has_value())
+	{
+		auto error = std::error_code();
+		std::filesystem::create_directories(cache_directory, error);
+
+		auto file = std::ofstream(cache_path(cache_directory, *key), std::ios::binary);
+		write_value(file, cache_magic);
+		write_value(file, job.format);
+		write_value(file, std::uint32_t(job.levels.size()));
+		for (auto const& level : job.levels)
+		{
+			write_value(file, level.width);
+			write_value(file, level.height);
+			write_value(file, std::uint32_t(level.data.size()));
+			file.write(reinterpret_cast<char const*>(level.data.data()), std::streamsize(level.data.size()));
+		}
+
+		if (!file)
+			std::cerr << "ERROR: Could not cache texture " <<
+				job.path << std::endl;
+	}
+
+	job.decode = milliseconds_since(start);
+}
+
+
+
+// Upload one level through the streaming pixel buffer
+auto TextureLoader::
+upload(
+	Job&              job,
+	std::size_t const level
+	)
+	-> std::size_t
+{
+	auto&       texture    = *job.texture;
+	auto const& data       = job.levels[level];
+	auto const  compressed = is_compressed(job.format);
+	auto const  storage    = GLEW_ARB_texture_storage;
+
+	state::bind_texture_for_edit(0U, texture.type_, texture.id_);
+
+	if (level == 0U)
+	{
+		texture.width_      = data.width;
+		texture.height_     = data.height;
+		texture.format_     = job.format;
+		texture.levels_     = GLuint(job.levels.size());
+		texture.size_bytes_ = 0U;
+		for (auto const& l : job.levels)
+			texture.size_bytes_ += l.data.size();
+
+		if (storage)
+			glTexStorage2D(texture.type_, GLsizei(texture.levels_), job.format,
+				GLsizei(data.width), GLsizei(data.height));
+
+		glTexParameteri(texture.type_, GL_TEXTURE_MAX_LEVEL, GLint(texture.levels_) - 1);
+		glTexParameteri(texture.type_, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(texture.type_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(texture.type_, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(texture.type_, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	}
+
+	// Orphan so the driver never waits on the previous transfer
+	if (buffer_ == 0U)
+		glGenBuffers(1, &buffer_);
+	state::bind_buffer(GL_PIXEL_UNPACK_BUFFER, buffer_);
+
+	auto const size = GLsizeiptr(data.data.size());
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	auto const mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (!mapped)
+	{
+		std::cerr << "ERROR: Could not map texture upload buffer for " <<
+			job.path << std::endl;
+		return data.data.size();
+	}
+	std::memcpy(mapped, data.data.data(), data.data.size());
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	auto const w = GLsizei(data.width);
+	auto const h = GLsizei(data.height);
+	auto const l = GLint(level);
+	if (compressed && storage)
+		glCompressedTexSubImage2D(texture.type_, l, 0, 0, w, h, job.format, GLsizei(size), nullptr);
+	else if (compressed)
+		glCompressedTexImage2D(texture.type_, l, job.format, w, h, 0, GLsizei(size), nullptr);
+	else if (storage)
+		glTexSubImage2D(texture.type_, l, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	else
+		glTexImage2D(texture.type_, l, GLint(job.format), w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+	return data.data.size();
+}
+
+} // namespace ogl
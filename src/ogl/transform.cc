@@ -0,0 +1,360 @@
+#include <e3d/ogl/transform.hh>
+
+#include <algorithm>
+
+// The widest path the compiler targets, ENGIN3D_NO_SIMD keeps the scalar one
+// so the tests can check it on any machine
+#if defined(ENGIN3D_NO_SIMD)
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define ENGIN3D_AVX
+#define ENGIN3D_SSE
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ENGIN3D_SSE
+#endif
+
+#include <glm/gtc/matrix_transform.hpp>
+
+
+
+namespace ogl
+{
+
+// Matrices
+auto Transform::
+matrix(
+	) const
+	-> glm::mat4
+{
+	// T * R * S without the products, scale only stretches the columns
+	auto result = glm::mat4_cast(orientation);
+	result[0]  *= scale.x;
+	result[1]  *= scale.y;
+	result[2]  *= scale.z;
+	result[3]   = glm::vec4(position, 1.0F);
+	return result;
+}
+
+auto Transform::
+normal_matrix(
+	) const
+	-> glm::mat3
+{
+	auto result = glm::mat3_cast(orientation);
+	result[0]  /= scale.x;
+	result[1]  /= scale.y;
+	result[2]  /= scale.z;
+	return result;
+}
+
+
+
+// Batches
+auto TransformBatch::
+size(
+	) const
+	-> std::size_t
+{
+	return x.size();
+}
+
+auto TransformBatch::
+resize(
+	std::size_t const size
+	)
+	-> void
+{
+	for (auto* const v : { &x, &y, &z, &qx, &qy, &qz, &qw, &sx, &sy, &sz })
+		v->resize(size);
+}
+
+auto TransformBatch::
+set(
+	std::size_t const index,
+	Transform   const& transform
+	)
+	-> void
+{
+	x[index]  = transform.position.x;
+	y[index]  = transform.position.y;
+	z[index]  = transform.position.z;
+	qx[index] = transform.orientation.x;
+	qy[index] = transform.orientation.y;
+	qz[index] = transform.orientation.z;
+	qw[index] = transform.orientation.w;
+	sx[index] = transform.scale.x;
+	sy[index] = transform.scale.y;
+	sz[index] = transform.scale.z;
+}
+
+auto TransformBatch::
+push_back(
+	Transform const& transform
+	)
+	-> void
+{
+	resize(size() + 1U);
+	set(size() - 1U, transform);
+}
+
+
+
+// Lane arithmetic, the composition below is written once for every width
+auto static inline load(float const* const p, float) -> float { return *p; }
+auto static inline splat(float const v, float) -> float { return v; }
+
+#if defined(ENGIN3D_AVX)
+auto static inline load(float const* const p, __m256) -> __m256 { return _mm256_loadu_ps(p); }
+auto static inline splat(float const v, __m256) -> __m256 { return _mm256_set1_ps(v); }
+#endif
+
+#if defined(ENGIN3D_SSE)
+auto static inline load(float const* const p, __m128) -> __m128 { return _mm_loadu_ps(p); }
+auto static inline splat(float const v, __m128) -> __m128 { return _mm_set1_ps(v); }
+#endif
+
+// GCC and Clang already give vector types their operators
+#if !defined(__GNUC__)
+#if defined(ENGIN3D_AVX)
+auto static inline operator+(__m256 const a, __m256 const b) -> __m256 { return _mm256_add_ps(a, b); }
+auto static inline operator-(__m256 const a, __m256 const b) -> __m256 { return _mm256_sub_ps(a, b); }
+auto static inline operator*(__m256 const a, __m256 const b) -> __m256 { return _mm256_mul_ps(a, b); }
+auto static inline operator/(__m256 const a, __m256 const b) -> __m256 { return _mm256_div_ps(a, b); }
+#endif
+
+#if defined(ENGIN3D_SSE)
+auto static inline operator+(__m128 const a, __m128 const b) -> __m128 { return _mm_add_ps(a, b); }
+auto static inline operator-(__m128 const a, __m128 const b) -> __m128 { return _mm_sub_ps(a, b); }
+auto static inline operator*(__m128 const a, __m128 const b) -> __m128 { return _mm_mul_ps(a, b); }
+auto static inline operator/(__m128 const a, __m128 const b) -> __m128 { return _mm_div_ps(a, b); }
+#endif
+#endif
+
+// Columns of T * R * S and of R * S^-1, one lane per transform
+template<typename V>
+struct Lanes
+{
+	V model[4][4];
+	V normal[3][3];
+};
+
+template<typename V>
+auto static inline
+compose(
+	TransformBatch const& batch,
+	std::size_t    const  i
+	)
+	-> Lanes<V>
+{
+	auto const one = splat(1.0F, V());
+	auto const two = splat(2.0F, V());
+	auto const nil = splat(0.0F, V());
+
+	auto const qx = load(&batch.qx[i], V());
+	auto const qy = load(&batch.qy[i], V());
+	auto const qz = load(&batch.qz[i], V());
+	auto const qw = load(&batch.qw[i], V());
+
+	auto const xx = qx * qx;
+	auto const yy = qy * qy;
+	auto const zz = qz * qz;
+	auto const xy = qx * qy;
+	auto const xz = qx * qz;
+	auto const yz = qy * qz;
+	auto const wx = qw * qx;
+	auto const wy = qw * qy;
+	auto const wz = qw * qz;
+
+	// Rotation columns, as glm::mat3_cast lays them out
+	V const rotation[3][3] = {
+		{ one - two * (yy + zz), two * (xy + wz),       two * (xz - wy) },
+		{ two * (xy - wz),       one - two * (xx + zz), two * (yz + wx) },
+		{ two * (xz + wy),       two * (yz - wx),       one - two * (xx + yy) } };
+
+	V const s[3] = {
+		load(&batch.sx[i], V()),
+		load(&batch.sy[i], V()),
+		load(&batch.sz[i], V()) };
+
+	auto result = Lanes<V>();
+	for (auto c = 0; c < 3; ++c)
+	{
+		auto const inverse = one / s[c];
+		for (auto r = 0; r < 3; ++r)
+		{
+			result.model[c][r]  = rotation[c][r] * s[c];
+			result.normal[c][r] = rotation[c][r] * inverse;
+		}
+		result.model[c][3] = nil;
+	}
+
+	result.model[3][0] = load(&batch.x[i], V());
+	result.model[3][1] = load(&batch.y[i], V());
+	result.model[3][2] = load(&batch.z[i], V());
+	result.model[3][3] = one;
+	return result;
+}
+
+// One transform at a time, for the tail and targets without SIMD
+auto static
+compute_scalar(
+	TransformBatch const& batch,
+	std::size_t    const  i,
+	glm::mat4*     const  models,
+	glm::mat3*     const  normals
+	)
+	-> void
+{
+	auto const lanes = compose<float>(batch, i);
+	for (auto c = 0; c < 4; ++c)
+		for (auto r = 0; r < 4; ++r)
+			models[i][c][r] = lanes.model[c][r];
+
+	if (normals)
+		for (auto c = 0; c < 3; ++c)
+			for (auto r = 0; r < 3; ++r)
+				normals[i][c][r] = lanes.normal[c][r];
+}
+
+#if defined(ENGIN3D_SSE)
+// Transpose four lanes back into four matrices. Normal columns are written
+// four floats wide in order, each spilling into the next column before that
+// is written, except the last
+auto static
+store(
+	__m128     const (&model)[4][4],
+	__m128     const (&normal)[3][3],
+	glm::mat4* const models,
+	glm::mat3* const normals
+	)
+	-> void
+{
+	for (auto c = 0; c < 4; ++c)
+	{
+		auto a = model[c][0];
+		auto b = model[c][1];
+		auto d = model[c][2];
+		auto e = model[c][3];
+		_MM_TRANSPOSE4_PS(a, b, d, e);
+		_mm_storeu_ps(&models[0][c][0], a);
+		_mm_storeu_ps(&models[1][c][0], b);
+		_mm_storeu_ps(&models[2][c][0], d);
+		_mm_storeu_ps(&models[3][c][0], e);
+	}
+
+	if (!normals)
+		return;
+
+	for (auto c = 0; c < 3; ++c)
+	{
+		auto a = normal[c][0];
+		auto b = normal[c][1];
+		auto d = normal[c][2];
+		auto e = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(a, b, d, e);
+
+		__m128 const columns[4] = { a, b, d, e };
+		for (auto k = 0; k < 4; ++k)
+		{
+			auto* const p = &normals[k][c][0];
+			if (c < 2)
+				_mm_storeu_ps(p, columns[k]);
+			else
+			{
+				_mm_storel_pi(reinterpret_cast<__m64*>(p), columns[k]);
+				_mm_store_ss(p + 2, _mm_movehl_ps(columns[k], columns[k]));
+			}
+		}
+	}
+}
+#endif
+
+
+
+// Matrices for a batch
+auto
+compute_matrices(
+	TransformBatch const& batch,
+	glm::mat4*     const  models,
+	glm::mat3*     const  normals
+	)
+	-> void
+{
+	auto const size = batch.size();
+	auto       i    = std::size_t(0U);
+
+#if defined(ENGIN3D_AVX)
+	for (; i + 8U <= size; i += 8U)
+	{
+		auto const lanes = compose<__m256>(batch, i);
+
+		// Halves go through the four wide transpose
+		__m128 model[2][4][4];
+		__m128 normal[2][3][3];
+		for (auto c = 0; c < 4; ++c)
+			for (auto r = 0; r < 4; ++r)
+			{
+				model[0][c][r] = _mm256_castps256_ps128(lanes.model[c][r]);
+				model[1][c][r] = _mm256_extractf128_ps(lanes.model[c][r], 1);
+			}
+		for (auto c = 0; c < 3; ++c)
+			for (auto r = 0; r < 3; ++r)
+			{
+				normal[0][c][r] = _mm256_castps256_ps128(lanes.normal[c][r]);
+				normal[1][c][r] = _mm256_extractf128_ps(lanes.normal[c][r], 1);
+			}
+
+		store(model[0], normal[0], models + i, normals ? normals + i : nullptr);
+		store(model[1], normal[1], models + i + 4U, normals ? normals + i + 4U : nullptr);
+	}
+#endif
+
+#if defined(ENGIN3D_SSE)
+	for (; i + 4U <= size; i += 4U)
+	{
+		auto const lanes = compose<__m128>(batch, i);
+		store(lanes.model, lanes.normal, models + i, normals ? normals + i : nullptr);
+	}
+#endif
+
+	for (; i < size; ++i)
+		compute_scalar(batch, i, models, normals);
+}
+
+
+
+// Interpolation
+auto
+interpolate(
+	Transform const& from,
+	Transform const& to,
+	float      const alpha
+	)
+	-> Transform
+{
+	auto result        = Transform();
+	result.position    = glm::mix(from.position, to.position, alpha);
+	result.orientation = glm::slerp(from.orientation, to.orientation, alpha);
+	result.scale       = glm::mix(from.scale, to.scale, alpha);
+	return result;
+}
+
+auto
+interpolate(
+	Snapshot const&         from,
+	Snapshot const&         to,
+	float            const  alpha,
+	std::vector<Transform>& result
+	)
+	-> void
+{
+	auto const shared = std::min(from.transforms.size(), to.transforms.size());
+
+	result.resize(to.transforms.size());
+	for (auto i = std::size_t(0U); i < shared; ++i)
+		result[i] = interpolate(from.transforms[i], to.transforms[i], alpha);
+	std::copy(to.transforms.begin() + std::ptrdiff_t(shared), to.transforms.end(), result.begin() + std::ptrdiff_t(shared));
+}
+
+} // namespace ogl
@@ -0,0 +1,208 @@
+#include <e3d/ogl/watcher.hh>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <set>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <e3d/ogl/profiler.hh>
+
+
+
+namespace ogl
+{
+
+// Key files by absolute path so events and shaders agree
+auto static
+normalise(
+	std::filesystem::path const& path
+	)
+	-> std::string
+{
+	auto error = std::error_code();
+	auto const absolute = std::filesystem::absolute(path, error);
+	return (error ? path : absolute).lexically_normal().string();
+}
+
+
+
+// Constructors
+ShaderWatcher::
+ShaderWatcher(
+	)
+{
+#ifdef __linux__
+	fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd_ < 0)
+		std::cerr << "ERROR: Could not start shader file watcher" << std::endl;
+#endif
+}
+
+ShaderWatcher::
+~ShaderWatcher(
+	)
+{
+#ifdef __linux__
+	if (fd_ >= 0)
+		close(fd_);
+#endif
+}
+
+
+
+// Watching
+auto ShaderWatcher::
+watch(
+	std::shared_ptr<Shader> const& shader
+	)
+	-> void
+{
+	for (auto const& file : shader->files())
+	{
+		auto const path = normalise(file);
+		files_[path].push_back(shader);
+
+#ifdef __linux__
+		if (fd_ < 0)
+			continue;
+
+		// Editors often save by replacing the file, so watch its directory.
+		// Only finished writes and renames, a created file may be half written
+		auto const directory = std::filesystem::path(path).parent_path().string();
+		auto const wd = inotify_add_watch(fd_, directory.c_str(),
+			IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (wd < 0)
+			std::cerr << "ERROR: Could not watch " <<
+				directory << std::endl;
+		else
+			directories_[wd] = directory;
+#else
+		auto error = std::error_code();
+		times_[path] = std::filesystem::last_write_time(path, error);
+#endif
+	}
+}
+
+auto ShaderWatcher::
+poll(
+	)
+	-> void
+{
+	auto const scope  = profiler::Scope("shader reload");
+	auto const start  = profiler::clock::now();
+	auto const idle   = reloading_.empty();
+	auto const before = reloads_;
+
+	auto changed = std::set<std::string>();
+
+#ifdef __linux__
+	// Drain events without blocking
+	alignas(inotify_event) auto buffer = std::array<char, 4096>();
+	while (fd_ >= 0)
+	{
+		auto const length = read(fd_, buffer.data(), buffer.size());
+		if (length <= 0)
+			break;
+
+		for (auto offset = std::size_t(0U); offset < std::size_t(length); )
+		{
+			auto const event = reinterpret_cast<inotify_event const*>(buffer.data() + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			auto const directory = directories_.find(event->wd);
+			if (directory == directories_.end() || event->len == 0U)
+				continue;
+
+			auto const path = normalise(std::filesystem::path(directory->second) / event->name);
+			if (files_.count(path))
+				changed.insert(path);
+		}
+	}
+#else
+	// Modification times, a few times a second is plenty
+	auto const now = std::filesystem::file_time_type::clock::now();
+	if (now - checked_ > std::chrono::milliseconds(250))
+	{
+		checked_ = now;
+		for (auto& [path, time] : times_)
+		{
+			auto       error   = std::error_code();
+			auto const current = std::filesystem::last_write_time(path, error);
+			if (!error && current != time)
+			{
+				time = current;
+				changed.insert(path);
+			}
+		}
+	}
+#endif
+
+	// Submit changed programs, the old ones keep drawing meanwhile
+	for (auto const& path : changed)
+	{
+		for (auto const& weak : files_[path])
+		{
+			auto const shader = weak.lock();
+			if (!shader || !shader->reload())
+				continue;
+
+			std::cout << "Reloading shader " <<
+				shader->name << " (" << path << ")" << std::endl;
+			++reloads_;
+
+			if (std::find(reloading_.begin(), reloading_.end(), shader) == reloading_.end())
+				reloading_.push_back(shader);
+		}
+	}
+
+	// Swap in the programs that have finished
+	reloading_.erase(
+		std::remove_if(reloading_.begin(), reloading_.end(),
+			[](std::shared_ptr<Shader> const& s) { return s->poll(); }),
+		reloading_.end());
+
+	// Frame time taken by the reload, from the first submit to the last swap
+	if (idle && reloads_ == before)
+		return;
+
+	auto const elapsed = std::chrono::duration<double, std::milli>(profiler::clock::now() - start).count();
+	reload_time_ = idle ? elapsed : std::max(reload_time_, elapsed);
+	if (reloading_.empty())
+		std::cout << "Shader reload cost at most " <<
+			reload_time_ << "ms of a frame" << std::endl;
+}
+
+
+
+// Statistics
+auto ShaderWatcher::
+is_reloading(
+	) const
+	-> bool
+{
+	return !reloading_.empty();
+}
+
+auto ShaderWatcher::
+reloads(
+	) const
+	-> std::uint64_t
+{
+	return reloads_;
+}
+
+auto ShaderWatcher::
+reload_time(
+	) const
+	-> double
+{
+	return reload_time_;
+}
+
+} // namespace ogl
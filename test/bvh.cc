@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <e3d/ogl/bvh.hh>
+
+
+
+using namespace ogl;
+
+auto static constexpr count_   = 5000U;
+auto static constexpr queries_ = 300U;
+
+auto static failures_ = 0;
+
+struct Scene
+{
+	std::mt19937                          random{ 1U };
+	std::uniform_real_distribution<float> position{ -100.0F, 100.0F };
+	std::uniform_real_distribution<float> extent{ 0.1F, 2.0F };
+	std::normal_distribution<float>       direction;
+
+	// Object bounds by object index, invalid once removed
+	std::vector<Aabb>       boxes;
+	std::vector<Bvh::Proxy> proxies;
+
+	auto
+	box(
+		)
+		-> Aabb
+	{
+		auto const centre = glm::vec3(position(random), position(random), position(random));
+		auto const half   = glm::vec3(extent(random), extent(random), extent(random));
+		return Aabb{ centre - half, centre + half };
+	}
+
+	auto
+	heading(
+		)
+		-> glm::vec3
+	{
+		return glm::normalize(glm::vec3(direction(random), direction(random), direction(random)));
+	}
+};
+
+auto static
+check(
+	std::string const& name,
+	bool        const  passed
+	)
+	-> void
+{
+	if (passed)
+		return;
+
+	std::cerr << "ERROR: " << name << std::endl;
+	++failures_;
+}
+
+auto static
+sorted(
+	std::vector<std::uint32_t> results
+	)
+	-> std::vector<std::uint32_t>
+{
+	std::sort(results.begin(), results.end());
+	return results;
+}
+
+// Every query against a scan over all live objects
+auto static
+compare(
+	std::string const& stage,
+	Scene&             scene,
+	Bvh         const& bvh
+	)
+	-> void
+{
+	auto boxes     = 0U;
+	auto frustums  = 0U;
+	auto rays      = 0U;
+	auto results   = std::vector<std::uint32_t>();
+	auto expected  = std::vector<std::uint32_t>();
+
+	for (auto q = 0U; q < queries_; ++q)
+	{
+		// Boxes a few objects wide
+		auto bounds = scene.box();
+		bounds.minimum -= glm::vec3(10.0F);
+		bounds.maximum += glm::vec3(10.0F);
+
+		results.clear();
+		expected.clear();
+		bvh.query(bounds, results);
+		for (auto i = std::uint32_t(0U); i < scene.boxes.size(); ++i)
+			if (scene.proxies[i] != Bvh::null && scene.boxes[i].overlaps(bounds))
+				expected.push_back(i);
+		if (sorted(results) != expected)
+			++boxes;
+
+		// Cameras looking a random way from a random point
+		auto const eye    = scene.box().centre();
+		auto const front  = scene.heading();
+		auto const up     = std::abs(front.z) < 0.99F ? glm::vec3(0.0F, 0.0F, 1.0F) : glm::vec3(1.0F, 0.0F, 0.0F);
+		auto const planes = frustum(
+			glm::perspective(glm::radians(60.0F), 16.0F / 9.0F, 0.1F, 50.0F) *
+			glm::lookAt(eye, eye + front, up));
+
+		results.clear();
+		expected.clear();
+		bvh.query(planes, results);
+		for (auto i = std::uint32_t(0U); i < scene.boxes.size(); ++i)
+			if (scene.proxies[i] != Bvh::null && classify(planes, scene.boxes[i]) != Containment::Outside)
+				expected.push_back(i);
+		if (sorted(results) != expected)
+			++frustums;
+
+		// Rays, the closest box entry wins
+		auto const ray = Ray{ eye, front };
+		auto const hit = bvh.raycast(ray);
+
+		auto closest = -1.0F;
+		for (auto i = std::uint32_t(0U); i < scene.boxes.size(); ++i)
+		{
+			if (scene.proxies[i] == Bvh::null)
+				continue;
+
+			auto const distance = intersect(ray, scene.boxes[i]);
+			if (distance >= 0.0F && (closest < 0.0F || distance < closest))
+				closest = distance;
+		}
+
+		if (hit.has_value() != (closest >= 0.0F) || (hit && std::abs(hit->distance - closest) > 1e-4F))
+			++rays;
+	}
+
+	check(stage + ": " + std::to_string(boxes) + " box queries differ", boxes == 0U);
+	check(stage + ": " + std::to_string(frustums) + " frustum queries differ", frustums == 0U);
+	check(stage + ": " + std::to_string(rays) + " raycasts differ", rays == 0U);
+}
+
+
+
+auto
+main(
+	)
+	-> int
+{
+	auto scene = Scene();
+	auto bvh   = Bvh();
+
+	for (auto i = 0U; i < count_; ++i)
+	{
+		scene.boxes.push_back(scene.box());
+		scene.proxies.push_back(bvh.insert(scene.boxes.back(), i));
+	}
+	compare("inserted", scene, bvh);
+
+	bvh.build();
+	compare("built", scene, bvh);
+
+	// Everything drifts, refit corrects the bounds and rotates the tree
+	auto drift = std::uniform_real_distribution<float>(-5.0F, 5.0F);
+	for (auto round = 0; round < 4; ++round)
+	{
+		for (auto i = 0U; i < count_; ++i)
+		{
+			auto const offset = glm::vec3(drift(scene.random), drift(scene.random), drift(scene.random));
+			scene.boxes[i].minimum += offset;
+			scene.boxes[i].maximum += offset;
+			bvh.move(scene.proxies[i], scene.boxes[i]);
+		}
+		bvh.refit();
+	}
+	compare("refitted", scene, bvh);
+
+	// A third removed, then put back elsewhere
+	for (auto i = 0U; i < count_; i += 3U)
+	{
+		bvh.remove(scene.proxies[i]);
+		scene.proxies[i] = Bvh::null;
+	}
+	compare("removed", scene, bvh);
+
+	for (auto i = 0U; i < count_; i += 3U)
+	{
+		scene.boxes[i]   = scene.box();
+		scene.proxies[i] = bvh.insert(scene.boxes[i], i);
+	}
+	bvh.refit();
+	compare("reinserted", scene, bvh);
+
+	bvh.build();
+	compare("rebuilt", scene, bvh);
+
+	std::cout << (failures_ == 0 ? "passed" : "failed") << std::endl;
+	return failures_ == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,186 @@
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <e3d/ogl/camera.hh>
+#include <e3d/ogl/jobs.hh>
+#include <e3d/ogl/occlusion.hh>
+
+
+
+using namespace ogl;
+
+// The camera sits at the origin looking down +y at a wall ten units away,
+// five units each side of its centre
+auto static constexpr wall_distance_ = 10.0F;
+auto static constexpr wall_half_     = 5.0F;
+
+auto static failures_ = 0;
+
+auto static
+box(
+	glm::vec3 const minimum,
+	glm::vec3 const maximum
+	)
+	-> Aabb
+{
+	return Aabb{ minimum, maximum };
+}
+
+auto static
+check(
+	std::string const& name,
+	bool        const  passed
+	)
+	-> void
+{
+	if (passed)
+		return;
+
+	std::cerr << "ERROR: " << name << std::endl;
+	++failures_;
+}
+
+// Whether the wall hides the whole box, its corners all behind the wall and
+// seen through it
+auto static
+hidden(
+	Aabb const& b
+	)
+	-> bool
+{
+	for (auto i = 0; i < 8; ++i)
+	{
+		auto const corner = glm::vec3(
+			i & 1 ? b.maximum.x : b.minimum.x,
+			i & 2 ? b.maximum.y : b.minimum.y,
+			i & 4 ? b.maximum.z : b.minimum.z);
+
+		if (corner.y <= wall_distance_)
+			return false;
+
+		auto const x = corner.x * wall_distance_ / corner.y;
+		auto const z = corner.z * wall_distance_ / corner.y;
+		if (std::abs(x) > wall_half_ || std::abs(z) > wall_half_)
+			return false;
+	}
+
+	return true;
+}
+
+auto static
+run(
+	std::string const& name,
+	bool        const  reverse_z,
+	bool        const  clip_zero_to_one
+	)
+	-> void
+{
+	auto camera             = Camera();
+	camera.fov              = 60.0F;
+	camera.near             = 0.1F;
+	camera.reverse_z        = reverse_z;
+	camera.clip_zero_to_one = clip_zero_to_one;
+	camera.aspect(1.0F, 1.0F);
+
+	// Two triangles make the wall
+	auto const corners = std::vector<glm::vec3>{
+		{ -wall_half_, wall_distance_, -wall_half_ },
+		{  wall_half_, wall_distance_, -wall_half_ },
+		{  wall_half_, wall_distance_,  wall_half_ },
+		{ -wall_half_, wall_distance_,  wall_half_ } };
+
+	auto constexpr order = std::array{ 0U, 1U, 2U, 0U, 2U, 3U };
+
+	auto wall = std::vector<obj::Vertex>(order.size());
+	for (auto i = std::size_t(0U); i < order.size(); ++i)
+		wall[i].position = corners[order[i]];
+
+	auto buffer = OcclusionBuffer(256U, 256U);
+	buffer.begin(camera.view_projection());
+	buffer.add(wall, glm::mat4(1.0F));
+	buffer.build();
+
+	// Well inside the silhouette, clear of the diagonal the two triangles
+	// share, which neither fills
+	check(name + ": box behind the wall is culled",
+		!buffer.visible(box({ 2.0F, 19.5F, -3.0F }, { 3.0F, 20.5F, -2.0F })));
+
+	// Small enough to be tested against single texels, ending halfway
+	// between the wall's edge and the far side of the texel that edge
+	// crosses. Covering that texel at all would cull it
+	auto const focal = 1.0F / std::tan(glm::radians(camera.fov) * 0.5F);
+	auto const edge  = (wall_half_ * focal / wall_distance_ * 0.5F + 0.5F) * float(buffer.width());
+	auto const past  = ((edge + std::ceil(edge)) * 0.5F / float(buffer.width()) * 2.0F - 1.0F) / focal;
+	check(name + ": box peeking past the silhouette is visible",
+		buffer.visible(box({ past * 19.0F - 0.01F, 19.0F, -2.51F }, { past * 19.0F, 19.01F, -2.5F })));
+
+	check(name + ": box in front of the wall is visible",
+		buffer.visible(box({ 2.0F, 4.5F, -3.0F }, { 3.0F, 5.5F, -2.0F })));
+
+	check(name + ": box crossing the near plane is visible",
+		buffer.visible(box(glm::vec3(-1.0F), glm::vec3(1.0F))));
+
+	// Bounds of the wall, and of a small piece of it, sit exactly at its depth
+	check(name + ": occluder does not cull itself",
+		buffer.visible(box(corners[0], corners[2])));
+
+	check(name + ": piece of the occluder does not cull itself",
+		buffer.visible(box({ 2.0F, wall_distance_, -2.51F }, { 2.01F, wall_distance_, -2.5F })));
+
+	// Random boxes through the batch test, none may be culled unless the
+	// wall really hides it
+	auto random   = std::mt19937(1U);
+	auto side     = std::uniform_real_distribution<float>(-15.0F, 15.0F);
+	auto distance = std::uniform_real_distribution<float>(2.0F, 60.0F);
+	auto extent   = std::uniform_real_distribution<float>(0.05F, 3.0F);
+
+	auto boxes  = std::vector<Aabb>();
+	auto inside = std::vector<std::uint8_t>();
+	for (auto i = 0; i < 20000; ++i)
+	{
+		auto const centre = glm::vec3(side(random), distance(random), side(random));
+		auto const half   = glm::vec3(extent(random));
+		boxes.push_back(box(centre - half, centre + half));
+		inside.push_back(1U);
+	}
+
+	jobs::start();
+	buffer.test(boxes, inside);
+	jobs::shutdown();
+
+	auto culled = 0U;
+	auto wrong  = 0U;
+	for (auto i = std::size_t(0U); i < boxes.size(); ++i)
+		if (!inside[i])
+		{
+			++culled;
+			if (!hidden(boxes[i]))
+				++wrong;
+		}
+
+	check(name + ": " + std::to_string(wrong) + " visible boxes culled", wrong == 0U);
+	check(name + ": nothing culled", culled > 0U);
+	std::cout << name << ": " << culled << " of " << boxes.size() << " culled" << std::endl;
+}
+
+
+
+auto
+main(
+	)
+	-> int
+{
+	run("depth", false, false);
+	run("zero to one depth", false, true);
+	run("reversed depth", true, true);
+	run("reversed depth, minus one to one", true, false);
+
+	std::cout << (failures_ == 0 ? "passed" : "failed") << std::endl;
+	return failures_ == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
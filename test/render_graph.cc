@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <e3d/ogl/render_graph.hh>
+#include <e3d/ogl/renderer.hh>
+
+
+
+using namespace ogl;
+
+// Returned when no headless context can be made on this machine
+auto static constexpr skipped_ = 77;
+
+auto static failures_ = 0;
+
+auto static
+check(
+	std::string const& name,
+	bool        const  passed
+	)
+	-> void
+{
+	if (passed)
+		return;
+
+	std::cerr << "ERROR: " << name << std::endl;
+	++failures_;
+}
+
+// Scene, bright pass, two rounds of ping-pong blur and a composite into the
+// output, plus a luminance pass only a debug view reads, which nothing reads
+auto static
+frame(
+	FramebufferPool&          pool,
+	std::vector<std::string>& executed
+	)
+	-> RenderGraph::Stats
+{
+	auto const width  = GLuint(renderer::width);
+	auto const height = GLuint(renderer::height);
+
+	auto const full = Framebuffer::Descriptor{ width, height, GL_RGBA16F };
+	auto const half = Framebuffer::Descriptor{ width / 2U, height / 2U, GL_RGBA16F, 0U };
+
+	auto graph = RenderGraph(pool);
+	auto const output    = graph.import("output");
+	auto const scene     = graph.create("scene", full);
+	auto const bright    = graph.create("bright", half);
+	auto const ping      = graph.create("ping", half);
+	auto const pong      = graph.create("pong", half);
+	auto const ping2     = graph.create("ping 2", half);
+	auto const pong2     = graph.create("pong 2", half);
+	auto const luminance = graph.create("luminance", Framebuffer::Descriptor{ 64U, 64U, GL_RGBA16F, 0U });
+	auto const debug     = graph.create("debug", half);
+
+	auto const pass = [&graph, &executed](
+		std::string_view                   const name,
+		std::vector<RenderGraph::Resource> const reads,
+		RenderGraph::Resource              const target)
+	{
+		graph.add_pass(name,
+			[&reads, target](RenderGraph::Builder& builder)
+			{
+				for (auto i = std::size_t(0U); i < reads.size(); ++i)
+					builder.read(reads[i], GLuint(i));
+				builder.write(target);
+			},
+			[&executed, name](RenderGraph const&)
+			{
+				executed.emplace_back(name);
+			});
+	};
+
+	pass("scene",             {},               scene);
+	pass("bright",            { scene },        bright);
+	pass("blur horizontal",   { bright },       ping);
+	pass("blur vertical",     { ping },         pong);
+	pass("blur horizontal 2", { pong },         ping2);
+	pass("blur vertical 2",   { ping2 },        pong2);
+	pass("luminance",         { scene },        luminance);
+	pass("debug",             { luminance },    debug);
+	pass("composite",         { scene, pong2 }, output);
+
+	executed.clear();
+	graph.execute();
+	pool.new_frame();
+	return graph.stats();
+}
+
+
+
+auto
+main(
+	)
+	-> int
+{
+	renderer::headless = true;
+	renderer::width    = 1280U;
+	renderer::height   = 720U;
+	try
+	{
+		renderer::start();
+	}
+	catch (std::runtime_error const& error)
+	{
+		std::cout << error.what() << ", skipped" << std::endl;
+		return skipped_;
+	}
+
+	{
+		auto pool     = FramebufferPool();
+		auto executed = std::vector<std::string>();
+
+		auto const first = frame(pool, executed);
+		check("7 passes run, " + std::to_string(first.passes) + " did", first.passes == 7U && executed.size() == 7U);
+		check("2 passes culled, " + std::to_string(first.culled) + " were", first.culled == 2U);
+		check("culled passes do not execute",
+			std::find(executed.begin(), executed.end(), "debug") == executed.end() &&
+			std::find(executed.begin(), executed.end(), "luminance") == executed.end());
+
+		// The blur targets take turns in two framebuffers beside the scene
+		check("3 framebuffers, " + std::to_string(first.framebuffers) + " used", first.framebuffers == 3U);
+		check("aliasing saves memory", first.bytes < first.unaliased_bytes);
+
+		// The next frame finds everything in the pool
+		auto const allocations = pool.allocations();
+		auto const second      = frame(pool, executed);
+		check("second frame allocates nothing", pool.allocations() == allocations);
+		check("second frame uses as much memory", second.bytes == first.bytes);
+
+		std::cout <<
+			first.passes << " passes, " <<
+			first.culled << " culled, " <<
+			first.framebuffers << " framebuffers, " <<
+			first.bytes / 1024U << "KiB instead of " <<
+			first.unaliased_bytes / 1024U << "KiB, compile " <<
+			second.compile << "ms, execute " <<
+			second.execute << "ms" << std::endl;
+	}
+
+	renderer::shutdown();
+
+	std::cout << (failures_ == 0 ? "passed" : "failed") << std::endl;
+	return failures_ == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
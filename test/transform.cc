@@ -0,0 +1,144 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <e3d/ogl/transform.hh>
+
+
+
+using namespace ogl;
+
+// Same selection as transform.cc, this file is built with the same flags
+#if defined(ENGIN3D_NO_SIMD)
+auto static constexpr path_ = "scalar";
+#elif defined(__AVX__)
+auto static constexpr path_ = "AVX";
+#elif defined(__SSE2__) || defined(_M_X64)
+auto static constexpr path_ = "SSE";
+#else
+auto static constexpr path_ = "scalar";
+#endif
+
+// Returned when the machine lacks the instructions this path was built for
+auto static constexpr skipped_ = 77;
+
+// Sizes around the AVX and SSE widths, so every tail length comes up
+auto static constexpr sizes_ = { 0U, 1U, 3U, 4U, 5U, 7U, 8U, 9U, 12U, 13U, 15U, 16U, 17U, 31U, 100U };
+
+auto static
+random_transform(
+	std::mt19937& random
+	)
+	-> Transform
+{
+	auto position = std::uniform_real_distribution<float>(-100.0F, 100.0F);
+	auto axis     = std::normal_distribution<float>();
+	auto scale    = std::uniform_real_distribution<float>(0.1F, 4.0F);
+	auto sign     = std::bernoulli_distribution(0.2);
+
+	auto q = glm::vec4(axis(random), axis(random), axis(random), axis(random));
+	q /= std::sqrt(glm::dot(q, q));
+
+	auto result        = Transform();
+	result.position    = glm::vec3(position(random), position(random), position(random));
+	result.orientation = glm::quat(q.w, q.x, q.y, q.z);
+	result.scale       = glm::vec3(scale(random), scale(random), scale(random));
+	if (sign(random))
+		result.scale.x = -result.scale.x;
+	return result;
+}
+
+// Relative to the larger magnitude, one scale can stretch a column by 40
+template<typename M>
+auto static
+matches(
+	M   const& a,
+	M   const& b,
+	int const  columns,
+	int const  rows
+	)
+	-> bool
+{
+	for (auto c = 0; c < columns; ++c)
+		for (auto r = 0; r < rows; ++r)
+			if (std::abs(a[c][r] - b[c][r]) > 1e-4F * std::max(1.0F, std::max(std::abs(a[c][r]), std::abs(b[c][r]))))
+				return false;
+	return true;
+}
+
+
+
+auto
+main(
+	)
+	-> int
+{
+#if defined(__AVX__) && defined(__GNUC__)
+	if (!__builtin_cpu_supports("avx"))
+	{
+		std::cout << "No AVX on this machine, skipped" << std::endl;
+		return skipped_;
+	}
+#endif
+
+	auto random   = std::mt19937(1U);
+	auto failures = 0;
+
+	for (auto const size : sizes_)
+	{
+		auto batch      = TransformBatch();
+		auto transforms = std::vector<Transform>();
+		for (auto i = 0U; i < size; ++i)
+		{
+			transforms.push_back(random_transform(random));
+			batch.push_back(transforms.back());
+		}
+
+		// One extra matrix each, which must be left alone
+		auto const guard   = glm::mat4(7.0F);
+		auto const guard3  = glm::mat3(7.0F);
+		auto       models  = std::vector<glm::mat4>(size + 1U, guard);
+		auto       normals = std::vector<glm::mat3>(size + 1U, guard3);
+		compute_matrices(batch, models.data(), normals.data());
+
+		// Models alone, normals skipped
+		auto alone = std::vector<glm::mat4>(size + 1U, guard);
+		compute_matrices(batch, alone.data());
+
+		for (auto i = 0U; i < size; ++i)
+		{
+			auto const& t     = transforms[i];
+			auto const  model =
+				glm::translate(glm::mat4(1.0F), t.position) *
+				glm::mat4_cast(t.orientation) *
+				glm::scale(glm::mat4(1.0F), t.scale);
+			auto const normal = glm::inverseTranspose(glm::mat3(model));
+
+			if (!matches(models[i], model, 4, 4) || !matches(alone[i], model, 4, 4))
+			{
+				std::cerr << "ERROR: " << path_ << " model " << i << " of " << size << " differs" << std::endl;
+				++failures;
+			}
+
+			if (!matches(normals[i], normal, 3, 3))
+			{
+				std::cerr << "ERROR: " << path_ << " normal " << i << " of " << size << " differs" << std::endl;
+				++failures;
+			}
+		}
+
+		if (models[size] != guard || normals[size] != guard3 || alone[size] != guard)
+		{
+			std::cerr << "ERROR: " << path_ << " wrote past the end of " << size << std::endl;
+			++failures;
+		}
+	}
+
+	std::cout << path_ << ": " << (failures == 0 ? "passed" : "failed") << std::endl;
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}